@@ -0,0 +1,212 @@
+#include "includes/analysis-pool.hpp"
+
+#include <obs-module.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+struct worker_queue {
+	std::mutex mutex;
+	std::deque<analysis_job *> jobs;
+};
+
+static std::vector<std::unique_ptr<worker_queue>> g_queues;
+static std::vector<std::thread> g_workers;
+static std::atomic<bool> g_running{false};
+static std::atomic<uint32_t> g_next_queue{0};
+static thread_tuning g_tuning;
+
+// g_pending counts queued jobs; workers sleep on g_wake_cv while it is zero.
+static std::mutex g_wake_mutex;
+static std::condition_variable g_wake_cv;
+static int g_pending = 0;
+
+static std::mutex g_done_mutex;
+static std::condition_variable g_done_cv;
+
+static void run_job(analysis_job *job)
+{
+	job->fn(job->arg);
+	job->finish_ns = os_gettime_ns();
+
+	{
+		std::lock_guard<std::mutex> lock(g_done_mutex);
+		job->state.store(ANALYSIS_JOB_DONE);
+	}
+	g_done_cv.notify_all();
+}
+
+static void consume_pending()
+{
+	std::lock_guard<std::mutex> lock(g_wake_mutex);
+	--g_pending;
+}
+
+// Own queue newest-first, then the oldest job of every other queue.
+static analysis_job *take_job(size_t self)
+{
+	const size_t count = g_queues.size();
+	for (size_t i = 0; i < count; ++i) {
+		worker_queue &q = *g_queues[(self + i) % count];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.jobs.empty())
+			continue;
+
+		analysis_job *job = nullptr;
+		if (i == 0) {
+			job = q.jobs.back();
+			q.jobs.pop_back();
+		} else {
+			job = q.jobs.front();
+			q.jobs.pop_front();
+		}
+		job->state.store(ANALYSIS_JOB_RUNNING);
+		return job;
+	}
+	return nullptr;
+}
+
+static void worker_main(size_t index)
+{
+	const std::string name = "aw-analysis-" + std::to_string(index);
+	os_set_thread_name(name.c_str());
+
+	if (g_tuning.priority != THREAD_PRIORITY_LEVEL_NORMAL || !g_tuning.cpus.empty()) {
+		const std::string report = thread_tuning_apply_current(g_tuning);
+		BLOG(LOG_INFO, "%s: %s", name.c_str(), report.c_str());
+	}
+
+	while (g_running.load()) {
+		if (analysis_job *job = take_job(index)) {
+			consume_pending();
+			run_job(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(g_wake_mutex);
+		g_wake_cv.wait(lock, [] { return !g_running.load() || g_pending > 0; });
+	}
+}
+
+void analysis_pool_start(int threads, const thread_tuning &tuning)
+{
+	if (g_running.load())
+		return;
+
+	if (threads < 0)
+		threads = std::max(1, os_get_logical_cores() / 2);
+	if (threads == 0) {
+		BLOG(LOG_INFO, "Analysis pool disabled; analysis runs on the render thread");
+		return;
+	}
+
+	g_tuning = tuning;
+	g_queues.clear();
+	for (int i = 0; i < threads; ++i)
+		g_queues.push_back(std::make_unique<worker_queue>());
+
+	g_running.store(true);
+	for (int i = 0; i < threads; ++i)
+		g_workers.emplace_back(worker_main, (size_t)i);
+
+	BLOG(LOG_INFO, "Analysis pool started with %d worker thread(s), requested priority %s", threads,
+	     thread_priority_name(tuning.priority));
+}
+
+void analysis_pool_stop()
+{
+	if (!g_running.load())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(g_wake_mutex);
+		g_running.store(false);
+	}
+	g_wake_cv.notify_all();
+
+	for (std::thread &worker : g_workers)
+		worker.join();
+	g_workers.clear();
+
+	// Owners wait on their jobs before they go away, so anything still
+	// queued here belongs to nobody.
+	g_queues.clear();
+	g_pending = 0;
+}
+
+int analysis_pool_size()
+{
+	return g_running.load() ? (int)g_workers.size() : 0;
+}
+
+void analysis_pool_submit(analysis_job *job)
+{
+	job->finish_ns = 0;
+	job->ran_inline = false;
+
+	if (!g_running.load()) {
+		job->state.store(ANALYSIS_JOB_RUNNING);
+		job->ran_inline = true;
+		run_job(job);
+		return;
+	}
+
+	const size_t index = g_next_queue.fetch_add(1) % g_queues.size();
+	{
+		worker_queue &q = *g_queues[index];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		job->queue = (int)index;
+		job->state.store(ANALYSIS_JOB_QUEUED);
+		q.jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_wake_mutex);
+		++g_pending;
+	}
+	g_wake_cv.notify_one();
+}
+
+bool analysis_pool_wait(analysis_job *job)
+{
+	const int state = job->state.load();
+	if (state == ANALYSIS_JOB_IDLE)
+		return false;
+	if (state == ANALYSIS_JOB_DONE)
+		return true;
+
+	// Not picked up yet: take it back and run it here.
+	if (state == ANALYSIS_JOB_QUEUED && job->queue >= 0 && (size_t)job->queue < g_queues.size()) {
+		bool claimed = false;
+		{
+			worker_queue &q = *g_queues[(size_t)job->queue];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			auto it = std::find(q.jobs.begin(), q.jobs.end(), job);
+			if (it != q.jobs.end()) {
+				q.jobs.erase(it);
+				job->state.store(ANALYSIS_JOB_RUNNING);
+				claimed = true;
+			}
+		}
+		if (claimed) {
+			consume_pending();
+			job->ran_inline = true;
+			run_job(job);
+			return true;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(g_done_mutex);
+	g_done_cv.wait(lock, [job] { return job->state.load() == ANALYSIS_JOB_DONE; });
+	return true;
+}
@@ -0,0 +1,117 @@
+#include "includes/analysis-scheduler.hpp"
+
+#include <obs-module.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+
+struct shared_spectrum {
+	uintptr_t input = 0;
+	uint64_t frame_ts = 0;
+	std::vector<float> mags;
+};
+
+static std::mutex g_sched_mutex;
+static std::array<int, kAnalysisSlots> g_slot_load{};
+static uint64_t g_last_frame_ts = 0;
+static uint64_t g_frame_index = 0;
+static std::vector<shared_spectrum> g_spectra;
+
+// Advances the shared frame counter the first time a new video frame is seen.
+// Must be called with g_sched_mutex held.
+static uint64_t current_frame_locked(uint64_t *frame_ts)
+{
+	const uint64_t ts = obs_get_video_frame_time();
+	if (ts != g_last_frame_ts) {
+		g_last_frame_ts = ts;
+		++g_frame_index;
+	}
+	if (frame_ts)
+		*frame_ts = ts;
+	return g_frame_index;
+}
+
+int analysis_scheduler_acquire_slot()
+{
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	int best = 0;
+	for (int i = 1; i < kAnalysisSlots; ++i) {
+		if (g_slot_load[(size_t)i] < g_slot_load[(size_t)best])
+			best = i;
+	}
+	++g_slot_load[(size_t)best];
+	return best;
+}
+
+void analysis_scheduler_release_slot(int slot)
+{
+	if (slot < 0 || slot >= kAnalysisSlots)
+		return;
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	if (g_slot_load[(size_t)slot] > 0)
+		--g_slot_load[(size_t)slot];
+}
+
+bool analysis_scheduler_is_due(int slot, int period)
+{
+	if (period <= 1)
+		return true;
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	const uint64_t frame = current_frame_locked(nullptr);
+	return (frame + (uint64_t)std::max(0, slot)) % (uint64_t)period == 0;
+}
+
+int analysis_scheduler_fft_period()
+{
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	int registered = 0;
+	for (int load : g_slot_load)
+		registered += load;
+	return registered > kFullRateAnalyzers ? 2 : 1;
+}
+
+bool analysis_scheduler_lookup_spectrum(uintptr_t input, size_t bins, std::vector<float> &mags)
+{
+	if (input == 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	uint64_t frame_ts = 0;
+	current_frame_locked(&frame_ts);
+	if (frame_ts == 0)
+		return false;
+
+	for (const shared_spectrum &entry : g_spectra) {
+		if (entry.input == input && entry.frame_ts == frame_ts && entry.mags.size() == bins) {
+			mags = entry.mags;
+			return true;
+		}
+	}
+	return false;
+}
+
+void analysis_scheduler_publish_spectrum(uintptr_t input, const std::vector<float> &mags)
+{
+	if (input == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_sched_mutex);
+	uint64_t frame_ts = 0;
+	current_frame_locked(&frame_ts);
+	if (frame_ts == 0)
+		return;
+
+	// Entries from earlier frames can never match again.
+	g_spectra.erase(std::remove_if(g_spectra.begin(), g_spectra.end(),
+				       [frame_ts](const shared_spectrum &e) { return e.frame_ts != frame_ts; }),
+			g_spectra.end());
+
+	for (shared_spectrum &entry : g_spectra) {
+		if (entry.input == input && entry.mags.size() == mags.size()) {
+			entry.mags = mags;
+			return;
+		}
+	}
+	g_spectra.push_back({input, frame_ts, mags});
+}
@@ -0,0 +1,846 @@
+#include "includes/audio-analyzer.hpp"
+#include "includes/analysis-scheduler.hpp"
+#include "includes/audio-source-index.hpp"
+#include "includes/fft-kernels.hpp"
+#include "includes/pipeline-trace.hpp"
+#include "includes/probes.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <locale>
+#include <sstream>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *S_AUDIO_SOURCE = "audio_source";
+static const char *S_AUDIO_SOURCE_UUID = "audio_source_uuid";
+static const char *S_REACT_DB = "react_db";
+static const char *S_PEAK_DB = "peak_db";
+static const char *S_ATTACK_MS = "attack_ms";
+static const char *S_RELEASE_MS = "release_ms";
+static const char *S_FFT_SIZE = "fft_size";
+static const char *S_BAND_COUNT = "band_count";
+static const char *S_CPU_BUDGET_MS = "cpu_budget_ms";
+static const char *S_WEIGHTING = "weighting";
+static const char *S_TILT_DB_PER_OCTAVE = "tilt_db_per_octave";
+static const char *S_GAIN_CURVE = "gain_curve";
+
+static constexpr float kMaxSampleAmplitude = 16.0f;
+
+// Spectral tilt is 0 dB here and rises or falls by the set amount per
+// octave away from it. The combined weighting gain is clamped to kGainMinDb
+// .. kGainMaxDb so the curve cannot blow up near DC or Nyquist.
+static constexpr double kTiltPivotHz = 1000.0;
+static constexpr float kGainMinDb = -60.0f;
+static constexpr float kGainMaxDb = 24.0f;
+static constexpr size_t kMaxGainPoints = 32;
+
+// Quality steps the CPU governor walks through, cheapest last. hop skips
+// analysis ticks, fft_div and band_div shrink the transform and band count,
+// and peak_slots bounds the band shuffle.
+struct governor_step {
+	int hop;
+	int fft_div;
+	int band_div;
+	int peak_slots;
+	const char *label;
+};
+
+static const governor_step kGovernorSteps[] = {
+	{1, 1, 1, 14, "full quality"},
+	{2, 1, 1, 14, "half analysis rate"},
+	{2, 2, 1, 14, "half rate, half FFT"},
+	{3, 2, 2, 10, "third rate, half FFT, half bands"},
+	{4, 4, 2, 6, "quarter rate, quarter FFT, half bands, fewer peaks"},
+};
+static constexpr int kGovernorMaxLevel = int(sizeof(kGovernorSteps) / sizeof(kGovernorSteps[0])) - 1;
+
+// Degrade after ~0.5 s over budget, restore only after ~3 s well under it so
+// a restored step that lands near the budget does not flap.
+static constexpr int kGovernorDegradeTicks = 30;
+static constexpr int kGovernorRestoreTicks = 180;
+static constexpr float kGovernorRestoreRatio = 0.35f;
+
+static inline float amp_to_db(float amp)
+{
+	amp = std::max(amp, 0.000001f);
+	return 20.0f * std::log10(amp);
+}
+
+static inline float db_to_norm(float db, float react_db, float peak_db)
+{
+	if (peak_db <= react_db)
+		return 0.0f;
+	return clamp01((db - react_db) / (peak_db - react_db));
+}
+
+static inline float hash01(float n)
+{
+	return std::fmod(std::sin(n) * 43758.5453123f, 1.0f) < 0.0f
+		       ? std::fmod(std::sin(n) * 43758.5453123f, 1.0f) + 1.0f
+		       : std::fmod(std::sin(n) * 43758.5453123f, 1.0f);
+}
+
+static inline int clamp_pow2(int value, int min_value, int max_value)
+{
+	value = std::clamp(value, min_value, max_value);
+	int p = 1;
+	while (p < value)
+		p <<= 1;
+	int lower = p >> 1;
+	if (lower < min_value)
+		return p;
+	if (p > max_value)
+		return lower;
+	return (value - lower) < (p - value) ? lower : p;
+}
+
+// The Hann window is generated once per size in double precision, like the
+// twiddles for the generic transform.
+static void build_fft_tables(audio_analyzer *s, size_t n)
+{
+	const double pi = 3.14159265358979323846;
+
+	fft_build_twiddles(s->fft_twiddles, n);
+
+	s->fft_window.resize(n);
+	for (size_t i = 0; i < n; ++i)
+		s->fft_window[i] = float(0.5 - 0.5 * std::cos(2.0 * pi * double(i) / double(n - 1)));
+
+	s->fft_buffer.assign(n, std::complex<float>(0.0f, 0.0f));
+}
+
+// IEC 61672 A and C curves, normalised to 0 dB at 1 kHz.
+static double weighting_db(int weighting, double hz)
+{
+	const double f2 = hz * hz;
+	const double c1 = 20.598997 * 20.598997;
+	const double c4 = 12194.217 * 12194.217;
+	if (weighting == AUDIO_WEIGHTING_A) {
+		const double r = c4 * f2 * f2 /
+				 ((f2 + c1) * std::sqrt((f2 + 107.65265 * 107.65265) * (f2 + 737.86223 * 737.86223)) *
+				  (f2 + c4));
+		return 20.0 * std::log10(r) + 2.00;
+	}
+	if (weighting == AUDIO_WEIGHTING_C)
+		return 20.0 * std::log10(c4 * f2 / ((f2 + c1) * (f2 + c4))) + 0.06;
+	return 0.0;
+}
+
+// Linear in log frequency between points, flat beyond the first and last.
+static double gain_curve_db(const std::vector<gain_point> &curve, double hz)
+{
+	if (curve.empty())
+		return 0.0;
+	if (hz <= curve.front().hz)
+		return curve.front().db;
+	if (hz >= curve.back().hz)
+		return curve.back().db;
+	for (size_t i = 1; i < curve.size(); ++i) {
+		const gain_point &a = curve[i - 1];
+		const gain_point &b = curve[i];
+		if (hz > b.hz)
+			continue;
+		const double t = std::log(hz / a.hz) / std::log(double(b.hz) / a.hz);
+		return a.db + (b.db - a.db) * t;
+	}
+	return curve.back().db;
+}
+
+// Precomputes the linear gain of every bin so weighting costs one multiply
+// per bin in the band pass, which touches each bin anyway.
+static void build_bin_gain(audio_analyzer *s, size_t bins, size_t n)
+{
+	s->bin_gain.assign(bins, 1.0f);
+	s->bin_gain_dirty = false;
+	if (s->weighting == AUDIO_WEIGHTING_NONE && s->tilt_db_per_octave == 0.0f && s->gain_curve.empty())
+		return;
+
+	for (size_t k = 1; k < bins; ++k) {
+		const double hz = double(k) * double(s->sample_rate) / double(n);
+		const double db = weighting_db(s->weighting, hz) +
+				  double(s->tilt_db_per_octave) * std::log2(hz / kTiltPivotHz) +
+				  gain_curve_db(s->gain_curve, hz);
+		const float clamped = std::clamp(float(db), kGainMinDb, kGainMaxDb);
+		s->bin_gain[k] = std::pow(10.0f, clamped / 20.0f);
+	}
+}
+
+// Parses "Hz:dB" pairs separated by commas or spaces, e.g. "60:-3, 8000:+4".
+// Malformed pairs and frequencies outside 1 Hz..48 kHz are skipped and
+// counted in rejected.
+static std::vector<gain_point> parse_gain_curve(const char *text, int &rejected)
+{
+	std::vector<gain_point> curve;
+	rejected = 0;
+	const std::string src = text ? text : "";
+	size_t pos = 0;
+	while (pos < src.size()) {
+		const size_t end = std::min(src.find_first_of(", \t;", pos), src.size());
+		const std::string token = src.substr(pos, end - pos);
+		pos = end + 1;
+		if (token.empty())
+			continue;
+
+		const size_t colon = token.find(':');
+		if (colon == std::string::npos) {
+			++rejected;
+			continue;
+		}
+		// Always '.' as the decimal point, whatever the OBS locale.
+		auto parse = [](const std::string &v, float &out) {
+			std::istringstream in(v);
+			in.imbue(std::locale::classic());
+			in >> out;
+			return !in.fail() && in.eof() && std::isfinite(out);
+		};
+		gain_point p{};
+		if (!parse(token.substr(0, colon), p.hz) || !parse(token.substr(colon + 1), p.db) || p.hz < 1.0f ||
+		    p.hz > 48000.0f || curve.size() >= kMaxGainPoints) {
+			++rejected;
+			continue;
+		}
+		p.db = std::clamp(p.db, kGainMinDb, kGainMaxDb);
+		curve.push_back(p);
+	}
+
+	std::stable_sort(curve.begin(), curve.end(),
+			 [](const gain_point &a, const gain_point &b) { return a.hz < b.hz; });
+	// Duplicate frequencies would divide by a zero log span; the first one
+	// given wins.
+	curve.erase(std::unique(curve.begin(), curve.end(),
+				[](const gain_point &a, const gain_point &b) { return a.hz == b.hz; }),
+		    curve.end());
+	return curve;
+}
+
+static void release_audio_weak(audio_analyzer *s)
+{
+	if (!s || !s->audio_weak)
+		return;
+	obs_weak_source_release(s->audio_weak);
+	s->audio_weak = nullptr;
+}
+
+// NaN/Inf from a misbehaving upstream filter would otherwise poison the ring
+// and every FFT after it; denormals are flushed so they cannot slow the FFT.
+static inline float sanitize_sample(float v)
+{
+	if (!std::isfinite(v))
+		return 0.0f;
+	if (std::fabs(v) < 1.0e-30f)
+		return 0.0f;
+	return std::clamp(v, -kMaxSampleAmplitude, kMaxSampleAmplitude);
+}
+
+void audio_analyzer_push_audio(audio_analyzer *s, const float *left, const float *right, size_t frames, bool muted)
+{
+	if (!s)
+		return;
+
+	if (muted || frames == 0 || !left) {
+		if (muted && frames > 0) {
+			std::lock_guard<std::mutex> lock(s->ingest.mutex);
+			const size_t n = s->ingest.mono_ring.size();
+			if (n > 0) {
+				const size_t fill = std::min(frames, n);
+				for (size_t i = 0; i < fill; ++i) {
+					s->ingest.mono_ring[s->ingest.mono_pos] = 0.0f;
+					s->ingest.mono_pos = (s->ingest.mono_pos + 1) % n;
+					if (s->ingest.mono_count < n)
+						++s->ingest.mono_count;
+				}
+			}
+			s->ingest.raw_level = 0.0f;
+			s->ingest.raw_peak = 0.0f;
+		}
+		return;
+	}
+
+	float sum_sq = 0.0f;
+	float peak = 0.0f;
+
+	std::lock_guard<std::mutex> lock(s->ingest.mutex);
+	if (s->ingest.mono_ring.size() != s->ingest.ring_size) {
+		s->ingest.mono_ring.assign(s->ingest.ring_size, 0.0f);
+		s->ingest.mono_pos = 0;
+		s->ingest.mono_count = 0;
+	}
+
+	for (size_t i = 0; i < frames; ++i) {
+		const float l = left[i];
+		const float r = right ? right[i] : l;
+		const float mono = sanitize_sample(0.5f * (l + r));
+		sum_sq += mono * mono;
+		peak = std::max(peak, std::fabs(mono));
+
+		s->ingest.mono_ring[s->ingest.mono_pos] = mono;
+		s->ingest.mono_pos = (s->ingest.mono_pos + 1) % s->ingest.mono_ring.size();
+		if (s->ingest.mono_count < s->ingest.mono_ring.size())
+			++s->ingest.mono_count;
+	}
+
+	s->ingest.raw_level = std::sqrt(sum_sq / std::max<size_t>(1, frames));
+	s->ingest.raw_peak = peak;
+}
+
+static void audio_capture_cb(void *param, obs_source_t *, const audio_data *audio, bool muted)
+{
+	auto *s = static_cast<audio_analyzer *>(param);
+	if (!s || !audio)
+		return;
+
+	// Register as in flight before checking alive: shutdown clears alive and
+	// then waits for the counter, so one of the two always sees the other.
+	s->ingest.cb_inflight.fetch_add(1);
+	if (!s->alive.load()) {
+		s->ingest.cb_inflight.fetch_sub(1);
+		return;
+	}
+
+	AW_TRACE_SCOPE("audio_capture", audio->frames);
+	const uint64_t probe_t0 = AW_PROBE_CLOCK(audio_capture_exit);
+	AW_PROBE2(audio_capture_entry, aw_probe_id(s->owner), audio->frames);
+
+	const float *left = reinterpret_cast<const float *>(audio->data[0]);
+	const float *right = audio->data[1] ? reinterpret_cast<const float *>(audio->data[1]) : nullptr;
+	audio_analyzer_push_audio(s, left, right, audio->frames, muted);
+
+	AW_PROBE3(audio_capture_exit, aw_probe_id(s->owner), audio->frames, aw_probe_elapsed(probe_t0));
+
+	s->ingest.cb_inflight.fetch_sub(1);
+}
+
+static void detach_locked(audio_analyzer *s)
+{
+	if (!s->audio_weak)
+		return;
+
+	obs_source_t *target = obs_weak_source_get_source(s->audio_weak);
+	if (target) {
+		obs_source_remove_audio_capture_callback(target, audio_capture_cb, s);
+		obs_source_release(target);
+	}
+	release_audio_weak(s);
+}
+
+void audio_analyzer_detach(audio_analyzer *s)
+{
+	if (!s)
+		return;
+
+	std::lock_guard<std::mutex> lock(s->bind_mutex);
+	detach_locked(s);
+}
+
+// Attaching always drops the previous binding first, so overlapping
+// update/show calls can never leave a second capture callback registered.
+void audio_analyzer_attach(audio_analyzer *s)
+{
+	if (!s)
+		return;
+
+	std::lock_guard<std::mutex> lock(s->bind_mutex);
+	detach_locked(s);
+	if ((s->audio_source_uuid.empty() && s->audio_source_name.empty()) || !s->alive.load())
+		return;
+
+	// Bind by UUID so renaming the audio source keeps the binding. Settings
+	// saved before UUIDs were stored only have a name; the first successful
+	// lookup by name records the UUID in the owner's settings.
+	obs_source_t *target = nullptr;
+	if (!s->audio_source_uuid.empty()) {
+		target = obs_get_source_by_uuid(s->audio_source_uuid.c_str());
+	} else {
+		target = obs_get_source_by_name(s->audio_source_name.c_str());
+		const char *uuid = target ? obs_source_get_uuid(target) : nullptr;
+		if (uuid && *uuid) {
+			s->audio_source_uuid = uuid;
+			obs_data_t *owner_settings = s->owner ? obs_source_get_settings(s->owner) : nullptr;
+			if (owner_settings) {
+				obs_data_set_string(owner_settings, S_AUDIO_SOURCE_UUID, uuid);
+				obs_data_release(owner_settings);
+			}
+		}
+	}
+	if (!target) {
+		BLOG(LOG_WARNING, "Audio source '%s' not found",
+		     s->audio_source_name.empty() ? s->audio_source_uuid.c_str() : s->audio_source_name.c_str());
+		return;
+	}
+
+	s->audio_weak = obs_source_get_weak_source(target);
+	obs_source_add_audio_capture_callback(target, audio_capture_cb, s);
+	obs_source_release(target);
+}
+
+static void analyzer_tick(audio_analyzer *s, uint64_t now)
+{
+	float raw_level = 0.0f;
+	float raw_peak = 0.0f;
+	// Reused across ticks so copying the ring does not allocate.
+	std::vector<float> &ring = s->ring_snapshot;
+	size_t pos = 0;
+	size_t count = 0;
+	uintptr_t input = 0;
+
+	{
+		std::lock_guard<std::mutex> bind_lock(s->bind_mutex);
+		input = reinterpret_cast<uintptr_t>(s->audio_weak);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(s->ingest.mutex);
+		raw_level = s->ingest.raw_level;
+		raw_peak = s->ingest.raw_peak;
+		ring = s->ingest.mono_ring;
+		pos = s->ingest.mono_pos;
+		count = s->ingest.mono_count;
+	}
+
+	const float target_level = db_to_norm(amp_to_db(raw_level), s->react_db, s->peak_db);
+	const float target_peak = db_to_norm(amp_to_db(raw_peak), s->react_db, s->peak_db);
+
+	float dt = 1.0f / 60.0f;
+	if (s->last_ts_ns != 0 && now > s->last_ts_ns)
+		dt = float(double(now - s->last_ts_ns) / 1000000000.0);
+	s->last_ts_ns = now;
+
+	auto smooth = [dt](float current, float target, float attack_ms, float release_ms) {
+		const float tau = (target > current ? attack_ms : release_ms) / 1000.0f;
+		if (tau <= 0.000001f)
+			return target;
+		const float a = 1.0f - std::exp(-dt / tau);
+		return current + (target - current) * a;
+	};
+
+	s->level = clamp01(smooth(s->level, target_level, s->attack_ms, s->release_ms));
+	s->peak = clamp01(smooth(s->peak, target_peak, s->attack_ms * 0.5f, s->release_ms * 1.5f));
+
+	std::array<float, 64> raw_bands{};
+	s->bass = s->mid = s->treble = 0.0f;
+	if (ring.empty() || count < ring.size() / 2) {
+		for (float &band : s->bands)
+			band = clamp01(smooth(band, 0.0f, s->attack_ms, s->release_ms));
+		song_structure_idle(&s->structure, dt);
+		s->section_change = s->structure.section_change;
+		s->energy_trend = s->structure.energy_trend;
+		return;
+	}
+
+	// A degraded governor step transforms only the newest part of the ring.
+	const governor_step &step = kGovernorSteps[s->gov_level];
+	const size_t ring_n = ring.size();
+	const size_t n = std::min(ring_n, std::max<size_t>(256, ring_n / (size_t)step.fft_div));
+	// Analyzers on the same input share one spectrum per video frame; only
+	// the first one to tick runs the FFT. At full rate with many analyzers,
+	// one whose FFT is not due this frame keeps its last spectrum.
+	std::vector<float> &mags = s->fft_magnitudes;
+	const bool reuse_fft = step.hop == 1 && mags.size() == n / 2 &&
+			       !analysis_scheduler_is_due(s->sched_slot, analysis_scheduler_fft_period());
+	if (!analysis_scheduler_lookup_spectrum(input, n / 2, mags) && !reuse_fft) {
+		if (s->fft_twiddles.size() != n / 2 || s->fft_window.size() != n)
+			build_fft_tables(s, n);
+
+		const uint64_t fft_t0 = AW_PROBE_CLOCK(analysis_fft);
+		std::vector<std::complex<float>> &fft = s->fft_buffer;
+		for (size_t i = 0; i < n; ++i) {
+			const size_t idx = (pos + ring_n - n + i) % ring_n;
+			fft[i] = std::complex<float>(ring[idx] * s->fft_window[i], 0.0f);
+		}
+		// Supported sizes use a specialised kernel; the generic transform
+		// stays as the fallback.
+		const fft_kernel_fn kernel = fft_kernel_for_size(n);
+		if (kernel) {
+			kernel(fft.data());
+		} else if (!fft_inplace(fft, s->fft_twiddles)) {
+			if (!s->fft_logged_error) {
+				BLOG(LOG_ERROR, "FFT size %zu is not a power of two; spectrum disabled", n);
+				s->fft_logged_error = true;
+			}
+			for (float &band : s->bands)
+				band = clamp01(smooth(band, 0.0f, s->attack_ms, s->release_ms));
+			return;
+		}
+
+		mags.resize(n / 2);
+		for (size_t k = 0; k < n / 2; ++k)
+			mags[k] = std::abs(fft[k]);
+		analysis_scheduler_publish_spectrum(input, mags);
+
+		AW_PROBE3(analysis_fft, aw_probe_id(s->owner), n, aw_probe_elapsed(fft_t0));
+	}
+
+	const uint64_t bands_t0 = AW_PROBE_CLOCK(analysis_bands);
+	const int usable_bins = int(n / 2);
+	if (s->bin_gain_dirty || s->bin_gain.size() != n / 2)
+		build_bin_gain(s, n / 2, n);
+	const float *gain = s->bin_gain.data();
+	const int bands = std::clamp(std::max(std::min(s->band_count, 8), s->band_count / step.band_div), 1, 64);
+	for (int b = 0; b < bands; ++b) {
+		const float t0 = float(b) / float(bands);
+		const float t1 = float(b + 1) / float(bands);
+		const int bin0 = std::max(1, int(std::pow(t0, 2.0f) * usable_bins));
+		const int bin1 = std::max(bin0 + 1, int(std::pow(t1, 2.0f) * usable_bins));
+		float mag = 0.0f;
+		int c = 0;
+		for (int bin = bin0; bin < std::min(bin1, usable_bins); ++bin) {
+			mag += mags[(size_t)bin] * gain[bin];
+			++c;
+		}
+		mag = c > 0 ? mag / float(c) : 0.0f;
+		raw_bands[(size_t)b] = db_to_norm(amp_to_db(mag / float(n)), s->react_db, s->peak_db);
+	}
+
+	auto avg_raw_range = [&](int a, int b) {
+		float sum = 0.0f;
+		int c = 0;
+		for (int i = std::max(0, a); i < b && i < bands; ++i) {
+			sum += raw_bands[(size_t)i];
+			++c;
+		}
+		return c ? sum / float(c) : 0.0f;
+	};
+
+	const float raw_bass = avg_raw_range(0, std::max(1, bands / 4));
+	const float raw_mid = avg_raw_range(std::max(1, bands / 4), std::max(2, bands * 2 / 3));
+	const float raw_treble = avg_raw_range(std::max(2, bands * 2 / 3), bands);
+
+	s->bass = clamp01(smooth(s->bass, raw_bass, s->attack_ms, s->release_ms));
+	s->mid = clamp01(smooth(s->mid, raw_mid, s->attack_ms, s->release_ms));
+	s->treble = clamp01(smooth(s->treble, raw_treble, s->attack_ms, s->release_ms));
+
+	song_structure_update(&s->structure, raw_bands.data(), bands, target_level, now, dt);
+	s->section_change = s->structure.section_change;
+	s->energy_trend = s->structure.energy_trend;
+
+	std::array<float, 64> target_cells{};
+	std::array<bool, 64> used_bands{};
+
+	const float time_bucket = std::floor(float(now / 1000000000.0) * 3.0f);
+	const int peak_slots = std::min(step.peak_slots, bands);
+
+	for (int slot = 0; slot < peak_slots; ++slot) {
+		int best = -1;
+		float best_score = 0.0f;
+
+		for (int b = 0; b < bands; ++b) {
+			if (used_bands[(size_t)b])
+				continue;
+
+			const float left = raw_bands[(size_t)std::max(0, b - 1)];
+			const float right = raw_bands[(size_t)std::min(bands - 1, b + 1)];
+			const float local_contrast = std::max(0.0f, raw_bands[(size_t)b] - (left + right) * 0.35f);
+			const float score = raw_bands[(size_t)b] * 0.70f + local_contrast * 0.85f;
+
+			if (score > best_score) {
+				best_score = score;
+				best = b;
+			}
+		}
+
+		if (best < 0 || best_score <= 0.001f)
+			break;
+
+		used_bands[(size_t)best] = true;
+		if (best > 0)
+			used_bands[(size_t)best - 1] = true;
+		if (best + 1 < bands)
+			used_bands[(size_t)best + 1] = true;
+
+		const float h = hash01(float(best) * 19.731f + float(slot) * 7.113f + time_bucket * 0.173f);
+		const int center = std::clamp((int)std::floor(h * 64.0f), 0, 63);
+		const float gain = 0.72f + hash01(float(best) * 5.371f + float(slot) * 31.91f) * 0.55f;
+		const float amp = clamp01(raw_bands[(size_t)best] * gain * (0.65f + s->peak * 0.55f));
+		const int radius = 2 + (hash01(float(best) * 11.17f + float(slot) * 3.31f) > 0.62f ? 1 : 0);
+
+		for (int off = -radius; off <= radius; ++off) {
+			int idx = center + off;
+			while (idx < 0)
+				idx += 64;
+			while (idx >= 64)
+				idx -= 64;
+
+			const float d = std::fabs(float(off));
+			float falloff = 1.0f;
+			if (d >= 1.0f)
+				falloff = d < 2.0f ? 0.52f : (d < 3.0f ? 0.24f : 0.10f);
+
+			target_cells[(size_t)idx] = std::max(target_cells[(size_t)idx], amp * falloff);
+		}
+	}
+
+	const float floor_energy = s->level * 0.025f;
+	for (size_t i = 0; i < s->bands.size(); ++i) {
+		const float target = clamp01(std::max(target_cells[i], floor_energy));
+		s->bands[i] = clamp01(smooth(s->bands[i], target, s->attack_ms, s->release_ms));
+	}
+
+	AW_PROBE3(analysis_bands, aw_probe_id(s->owner), bands, aw_probe_elapsed(bands_t0));
+}
+
+static void governor_set_level(audio_analyzer *s, int level)
+{
+	const governor_step &step = kGovernorSteps[level];
+	const char *name = s->owner ? obs_source_get_name(s->owner) : "";
+	BLOG(LOG_INFO, "'%s': analysis %s quality to level %d (%s), cost %.3f ms/frame, budget %.3f ms",
+	     name ? name : "", level > s->gov_level ? "lowered" : "restored", level, step.label,
+	     s->gov_cost_ms, s->cpu_budget_ms);
+
+	s->gov_level = level;
+	s->gov_over_ticks = 0;
+	s->gov_under_ticks = 0;
+	s->gov_shown_level.store(level, std::memory_order_relaxed);
+}
+
+// Folds one measured analysis pass into the per-frame cost average and steps
+// the quality level when it stays outside the budget band long enough.
+static void governor_record(audio_analyzer *s, uint64_t cost_ns)
+{
+	const float hop = float(kGovernorSteps[s->gov_level].hop);
+	const float per_frame_ms = float(double(cost_ns) / 1000000.0) / hop;
+	s->gov_cost_ms = s->gov_cost_ms <= 0.0f ? per_frame_ms : s->gov_cost_ms * 0.9f + per_frame_ms * 0.1f;
+	s->gov_shown_cost_us.store(uint32_t(s->gov_cost_ms * 1000.0f), std::memory_order_relaxed);
+
+	if (s->cpu_budget_ms <= 0.0f) {
+		if (s->gov_level != 0)
+			governor_set_level(s, 0);
+		return;
+	}
+
+	if (s->gov_cost_ms > s->cpu_budget_ms) {
+		s->gov_under_ticks = 0;
+		if (++s->gov_over_ticks >= kGovernorDegradeTicks && s->gov_level < kGovernorMaxLevel)
+			governor_set_level(s, s->gov_level + 1);
+	} else if (s->gov_cost_ms < s->cpu_budget_ms * kGovernorRestoreRatio) {
+		s->gov_over_ticks = 0;
+		if (++s->gov_under_ticks >= kGovernorRestoreTicks && s->gov_level > 0)
+			governor_set_level(s, s->gov_level - 1);
+	} else {
+		s->gov_over_ticks = 0;
+		s->gov_under_ticks = 0;
+	}
+}
+
+void audio_analyzer_tick(audio_analyzer *s, uint64_t now)
+{
+	// Skipped hops leave the outputs as they are; the next analysed tick
+	// smooths over the whole elapsed time. The scheduler slot staggers hops
+	// so degraded analyzers do not all run on the same frame.
+	if (!analysis_scheduler_is_due(s->sched_slot, kGovernorSteps[s->gov_level].hop))
+		return;
+
+	AW_TRACE_SCOPE("analysis", uint64_t(s->fft_size));
+	const uint64_t probe_t0 = AW_PROBE_CLOCK(analysis_exit);
+	AW_PROBE2(analysis_entry, aw_probe_id(s->owner), s->fft_size);
+
+	const uint64_t t0 = os_gettime_ns();
+	analyzer_tick(s, now);
+	governor_record(s, os_gettime_ns() - t0);
+
+	AW_PROBE2(analysis_exit, aw_probe_id(s->owner), aw_probe_elapsed(probe_t0));
+}
+
+static void analyzer_job_run(void *arg)
+{
+	auto *s = static_cast<audio_analyzer *>(arg);
+	audio_analyzer_tick(s, s->job_now_ns);
+}
+
+static uint64_t frame_interval_ns()
+{
+	obs_video_info ovi = {};
+	if (obs_get_video_info(&ovi) && ovi.fps_num > 0 && ovi.fps_den > 0)
+		return uint64_t(1000000000ULL) * ovi.fps_den / ovi.fps_num;
+	return 1000000000ULL / 30;
+}
+
+void audio_analyzer_tick_async(audio_analyzer *s, uint64_t now)
+{
+	if (!s)
+		return;
+
+	audio_analyzer_wait(s);
+
+	s->job.fn = analyzer_job_run;
+	s->job.arg = s;
+	s->job_now_ns = now;
+	s->job.deadline_ns = os_gettime_ns() + frame_interval_ns();
+	analysis_pool_submit(&s->job);
+}
+
+bool audio_analyzer_wait(audio_analyzer *s)
+{
+	if (!s || !analysis_pool_wait(&s->job))
+		return false;
+
+	// A worker finishing after the next frame was due means the pool is
+	// oversubscribed; report it at most every ten seconds.
+	if (!s->job.ran_inline && s->job.finish_ns > s->job.deadline_ns) {
+		++s->job_late_count;
+		const uint64_t now = os_gettime_ns();
+		if (now - s->job_late_logged_ns > 10000000000ULL) {
+			const char *name = s->owner ? obs_source_get_name(s->owner) : "";
+			BLOG(LOG_WARNING, "'%s': analysis finished %.2f ms past its frame deadline (%u late so far)",
+			     name ? name : "", double(s->job.finish_ns - s->job.deadline_ns) / 1000000.0,
+			     s->job_late_count);
+			s->job_late_logged_ns = now;
+		}
+	}
+
+	s->job.state.store(ANALYSIS_JOB_IDLE);
+	return true;
+}
+
+void audio_analyzer_init(audio_analyzer *s, obs_source_t *owner)
+{
+	if (!s)
+		return;
+
+	s->owner = owner;
+	s->sched_slot = analysis_scheduler_acquire_slot();
+	s->structure.phase_ns = kSongFrameNs * (uint64_t)s->sched_slot / kAnalysisSlots;
+	obs_audio_info ai;
+	if (obs_get_audio_info(&ai) && ai.samples_per_sec > 0)
+		s->sample_rate = int(ai.samples_per_sec);
+}
+
+void audio_analyzer_shutdown(audio_analyzer *s)
+{
+	if (!s)
+		return;
+
+	audio_analyzer_wait(s);
+	s->alive.store(false);
+
+	audio_analyzer_detach(s);
+
+	for (int i = 0; i < 2000; ++i) {
+		if (s->ingest.cb_inflight.load() == 0)
+			break;
+		os_sleep_ms(1);
+	}
+
+	analysis_scheduler_release_slot(s->sched_slot);
+	s->sched_slot = -1;
+}
+
+void audio_analyzer_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_double(settings, S_REACT_DB, -55.0);
+	obs_data_set_default_double(settings, S_PEAK_DB, -6.0);
+	obs_data_set_default_int(settings, S_ATTACK_MS, 25);
+	obs_data_set_default_int(settings, S_RELEASE_MS, 180);
+	obs_data_set_default_int(settings, S_FFT_SIZE, 2048);
+	obs_data_set_default_int(settings, S_BAND_COUNT, 64);
+	obs_data_set_default_double(settings, S_CPU_BUDGET_MS, 1.0);
+	obs_data_set_default_int(settings, S_WEIGHTING, AUDIO_WEIGHTING_NONE);
+	obs_data_set_default_double(settings, S_TILT_DB_PER_OCTAVE, 0.0);
+	obs_data_set_default_string(settings, S_GAIN_CURVE, "");
+}
+
+void audio_analyzer_add_source_list(obs_properties_t *props)
+{
+	obs_property_t *audio = obs_properties_add_list(props, S_AUDIO_SOURCE_UUID, "Audio Source", OBS_COMBO_TYPE_LIST,
+							OBS_COMBO_FORMAT_STRING);
+	audio_source_index_fill_list(audio);
+}
+
+void audio_analyzer_add_properties(obs_properties_t *props, const audio_analyzer *a)
+{
+	obs_properties_add_float_slider(props, S_REACT_DB, "React at dB", -90.0, -1.0, 1.0);
+	obs_properties_add_float_slider(props, S_PEAK_DB, "Peak at dB", -60.0, 0.0, 1.0);
+	obs_properties_add_int_slider(props, S_ATTACK_MS, "Attack ms", 0, 500, 1);
+	obs_properties_add_int_slider(props, S_RELEASE_MS, "Release ms", 0, 2000, 1);
+
+	obs_property_t *fft =
+		obs_properties_add_list(props, S_FFT_SIZE, "FFT Size", OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(fft, "512", 512);
+	obs_property_list_add_int(fft, "1024", 1024);
+	obs_property_list_add_int(fft, "2048", 2048);
+	obs_property_list_add_int(fft, "4096", 4096);
+	obs_property_list_add_int(fft, "8192", 8192);
+	obs_properties_add_int_slider(props, S_BAND_COUNT, "Shader Bands", 8, 64, 1);
+
+	obs_property_t *weighting = obs_properties_add_list(props, S_WEIGHTING, "Frequency Weighting",
+							    OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(weighting, "None", AUDIO_WEIGHTING_NONE);
+	obs_property_list_add_int(weighting, "A-weighting", AUDIO_WEIGHTING_A);
+	obs_property_list_add_int(weighting, "C-weighting", AUDIO_WEIGHTING_C);
+
+	obs_property_t *tilt = obs_properties_add_float_slider(props, S_TILT_DB_PER_OCTAVE,
+								"Spectral Tilt (dB/octave)", -6.0, 12.0, 0.5);
+	obs_property_set_long_description(tilt, "Boosts bands above 1 kHz and cuts those below by this much per "
+						"octave. Music falls off by roughly 3-6 dB/octave.");
+
+	obs_property_t *curve = obs_properties_add_text(props, S_GAIN_CURVE, "Band Gain Curve", OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(curve, "Extra gain as Hz:dB points, e.g. \"60:-3, 8000:+4\". Points are "
+						 "joined on a log-frequency scale and the curve is flat beyond "
+						 "the first and last point.");
+
+	obs_property_t *budget =
+		obs_properties_add_float_slider(props, S_CPU_BUDGET_MS, "Analysis CPU Budget (ms/frame)", 0.0, 10.0, 0.05);
+	obs_property_set_long_description(budget, "Quality is lowered step by step while analysis stays over "
+						  "this budget and restored once it is well under. 0 disables.");
+
+	if (a) {
+		const int level = a->gov_shown_level.load(std::memory_order_relaxed);
+		const uint32_t cost_us = a->gov_shown_cost_us.load(std::memory_order_relaxed);
+		char status[160];
+		snprintf(status, sizeof(status), "Analysis quality: level %d, %s (%.2f ms/frame)", level,
+			 kGovernorSteps[std::clamp(level, 0, kGovernorMaxLevel)].label, double(cost_us) / 1000.0);
+		obs_properties_add_text(props, "analysis_governor_status", status, OBS_TEXT_INFO);
+	}
+}
+
+void audio_analyzer_update_settings(audio_analyzer *s, obs_data_t *settings)
+{
+	if (!s)
+		return;
+
+	audio_analyzer_wait(s);
+
+	// The list property stores the UUID; the name is kept in step with it as
+	// a readable fallback for older settings and log messages.
+	std::string uuid = obs_data_get_string(settings, S_AUDIO_SOURCE_UUID);
+	std::string name = obs_data_get_string(settings, S_AUDIO_SOURCE);
+	if (uuid.empty()) {
+		if (audio_source_index_find_uuid(name.c_str(), uuid))
+			obs_data_set_string(settings, S_AUDIO_SOURCE_UUID, uuid.c_str());
+	} else if (audio_source_index_find_name(uuid.c_str(), name)) {
+		obs_data_set_string(settings, S_AUDIO_SOURCE, name.c_str());
+	}
+	{
+		std::lock_guard<std::mutex> bind_lock(s->bind_mutex);
+		s->audio_source_uuid = uuid;
+		s->audio_source_name = name;
+	}
+	s->react_db = float(obs_data_get_double(settings, S_REACT_DB));
+	s->peak_db = float(obs_data_get_double(settings, S_PEAK_DB));
+	s->attack_ms = float(obs_data_get_int(settings, S_ATTACK_MS));
+	s->release_ms = float(obs_data_get_int(settings, S_RELEASE_MS));
+	s->band_count = std::clamp<int>((int)obs_data_get_int(settings, S_BAND_COUNT), 1, 64);
+	s->cpu_budget_ms = std::max(0.0f, float(obs_data_get_double(settings, S_CPU_BUDGET_MS)));
+
+	s->weighting = std::clamp((int)obs_data_get_int(settings, S_WEIGHTING), (int)AUDIO_WEIGHTING_NONE,
+				  (int)AUDIO_WEIGHTING_C);
+	s->tilt_db_per_octave = std::clamp(float(obs_data_get_double(settings, S_TILT_DB_PER_OCTAVE)), -6.0f, 12.0f);
+	int rejected = 0;
+	s->gain_curve = parse_gain_curve(obs_data_get_string(settings, S_GAIN_CURVE), rejected);
+	if (rejected > 0) {
+		const char *name = s->owner ? obs_source_get_name(s->owner) : "";
+		BLOG(LOG_WARNING, "'%s': ignored %d malformed band gain curve point(s)", name ? name : "", rejected);
+	}
+	s->bin_gain_dirty = true;
+
+	s->fft_size = clamp_pow2((int)obs_data_get_int(settings, S_FFT_SIZE), 512, 8192);
+
+	// The audio thread sizes the ring from its own copy so it never reads the
+	// analysis cache lines. The ring itself is (re)allocated by the first
+	// packet that arrives, so analyzers that never receive audio stay empty.
+	std::lock_guard<std::mutex> audio_lock(s->ingest.mutex);
+	s->ingest.ring_size = (size_t)s->fft_size;
+}
@@ -0,0 +1,246 @@
+#include "includes/audio-shader-filter.hpp"
+#include "includes/pipeline-trace.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *kFilterId = "audio_shader_engine_filter";
+static const char *kFilterName = "Audio Shader Effect";
+static const char *kDefaultEffect = "effects/reactive-camera-frame.effect";
+
+static obs_source_info g_filter_info = {};
+
+static const char *filter_name(void *)
+{
+	return kFilterName;
+}
+
+static bool effect_path_modified(obs_properties_t *props, obs_property_t *, obs_data_t *settings)
+{
+	const char *path = shader_effect_settings_path(settings);
+	std::string effect_path = path && *path ? path : shader_effect_module_path(kDefaultEffect);
+	shader_effect_rebuild_controls(props, effect_path);
+	return true;
+}
+
+static bool reload_effect_clicked(obs_properties_t *props, obs_property_t *, void *data)
+{
+	auto *f = static_cast<audio_shader_filter *>(obs_properties_get_param(props));
+	if (!f)
+		f = static_cast<audio_shader_filter *>(data);
+	if (!f)
+		return false;
+
+	std::lock_guard<std::mutex> lock(f->mutex);
+	shader_effect_request_recompile(&f->shader);
+	f->render_logged_no_effect = false;
+	f->render_logged_no_technique = false;
+
+	BLOG(LOG_INFO, "Manual shader reload queued for filter '%s'", obs_source_get_name(f->self));
+	return true;
+}
+
+static obs_properties_t *filter_properties(void *data)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	obs_properties_t *props = obs_properties_create();
+	obs_properties_set_param(props, f, nullptr);
+
+	audio_analyzer_add_source_list(props);
+	shader_effect_add_path_property(props, effect_path_modified);
+	obs_properties_add_button(props, "reload_shader", "\xe2\x86\xba  Reload Shader", reload_effect_clicked);
+
+	obs_properties_add_text(props, "filter_effect_help",
+				"Effects that declare 'uniform texture2d image' receive the filtered source and decide "
+				"how to composite it. Other effects are drawn on top of the source.",
+				OBS_TEXT_INFO);
+
+	audio_analyzer_add_properties(props, f ? &f->analyzer : nullptr);
+
+	std::string meta_effect_path = f && !f->shader.effect_path.empty() ? f->shader.effect_path
+									    : shader_effect_module_path(kDefaultEffect);
+	shader_effect_rebuild_controls(props, meta_effect_path);
+
+	return props;
+}
+
+static void filter_defaults(obs_data_t *settings)
+{
+	shader_effect_defaults(settings, kDefaultEffect);
+	audio_analyzer_defaults(settings);
+}
+
+static void filter_update(void *data, obs_data_t *settings)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (!f)
+		return;
+
+	audio_analyzer_detach(&f->analyzer);
+
+	std::lock_guard<std::mutex> lock(f->mutex);
+
+	audio_analyzer_update_settings(&f->analyzer, settings);
+	if (shader_effect_update_settings(&f->shader, settings)) {
+		f->render_logged_no_effect = false;
+		f->render_logged_no_technique = false;
+	}
+
+	// Audio is bound on first show, not while a scene collection loads.
+	if (obs_source_showing(f->self))
+		audio_analyzer_attach(&f->analyzer);
+}
+
+static void *filter_create(obs_data_t *settings, obs_source_t *source)
+{
+	auto *f = new (std::nothrow) audio_shader_filter{};
+	if (!f)
+		return nullptr;
+
+	f->self = source;
+	audio_analyzer_init(&f->analyzer, source);
+	filter_update(f, settings);
+	return f;
+}
+
+static void filter_destroy(void *data)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (!f)
+		return;
+
+	audio_analyzer_shutdown(&f->analyzer);
+
+	obs_enter_graphics();
+	shader_effect_destroy(&f->shader);
+	obs_leave_graphics();
+
+	delete f;
+}
+
+static void filter_video_tick(void *data, float)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (!f)
+		return;
+
+	// Hidden filters skip analysis, like hidden sources.
+	std::lock_guard<std::mutex> lock(f->mutex);
+	if (obs_source_showing(f->self))
+		audio_analyzer_tick_async(&f->analyzer, os_gettime_ns());
+}
+
+static void filter_render(void *data, gs_effect_t *)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (!f)
+		return;
+
+	AW_TRACE_SCOPE("filter_render");
+
+	std::lock_guard<std::mutex> lock(f->mutex);
+	audio_analyzer_wait(&f->analyzer);
+
+	obs_source_t *target = obs_filter_get_target(f->self);
+	const uint32_t width = target ? obs_source_get_base_width(target) : 0;
+	const uint32_t height = target ? obs_source_get_base_height(target) : 0;
+	if (!width || !height) {
+		obs_source_skip_video_filter(f->self);
+		return;
+	}
+
+	shader_effect_load_if_needed(&f->shader);
+	shader_effect_select_tier(&f->shader, shader_effect_auto_tier(&f->shader, width, height));
+	const char *tech_name = shader_effect_technique_name(&f->shader);
+	if (!tech_name) {
+		if (!f->shader.effect && !f->render_logged_no_effect) {
+			BLOG(LOG_WARNING, "Filter '%s' has no loaded effect. Selected path='%s'",
+			     obs_source_get_name(f->self), f->shader.effect_path.c_str());
+			f->render_logged_no_effect = true;
+		} else if (f->shader.effect && !f->render_logged_no_technique) {
+			BLOG(LOG_ERROR, "Effect '%s' has no Draw, Solid, or Default technique",
+			     f->shader.effect_path.c_str());
+			f->render_logged_no_technique = true;
+		}
+		obs_source_skip_video_filter(f->self);
+		return;
+	}
+
+	// Several views can draw the filter in one frame; upload bands once per frame.
+	const uint64_t frame_ts = obs_get_video_frame_time();
+	if (frame_ts == 0 || frame_ts != f->uploaded_frame_ts) {
+		shader_effect_update_band_texture(&f->shader, f->analyzer, f->self);
+		f->uploaded_frame_ts = frame_ts;
+	}
+
+	if (!obs_source_process_filter_begin(f->self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING))
+		return;
+
+	// The compiled effect is shared with other instances, and rendering the
+	// parent can draw them, so parameters are written only after that.
+	// Effects that sample the parent composite it themselves, straight from
+	// the filter chain's texture.
+	if (f->shader.samples_image) {
+		shader_effect_set_params(&f->shader, f->analyzer, width, height);
+		obs_source_process_filter_tech_end(f->self, f->shader.effect, width, height, tech_name);
+		return;
+	}
+
+	// Overlay effects: draw the parent untouched, then the effect on top at
+	// the parent's size. No intermediate texrender or canvas-sized composite.
+	obs_source_process_filter_end(f->self, obs_get_base_effect(OBS_EFFECT_DEFAULT), width, height);
+
+	shader_effect_set_params(&f->shader, f->analyzer, width, height);
+	gs_technique_t *tech = shader_effect_technique(&f->shader);
+	gs_blend_state_push();
+	gs_enable_blending(true);
+	gs_blend_function(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA);
+
+	const size_t passes = gs_technique_begin(tech);
+	for (size_t i = 0; i < passes; ++i) {
+		gs_technique_begin_pass(tech, i);
+		gs_draw_sprite(nullptr, 0, width, height);
+		gs_technique_end_pass(tech);
+	}
+	gs_technique_end(tech);
+
+	gs_blend_state_pop();
+}
+
+static void filter_show(void *data)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (f)
+		audio_analyzer_attach(&f->analyzer);
+}
+
+static void filter_hide(void *data)
+{
+	auto *f = static_cast<audio_shader_filter *>(data);
+	if (f)
+		audio_analyzer_detach(&f->analyzer);
+}
+
+extern "C" void register_audio_shader_filter(void)
+{
+	std::memset(&g_filter_info, 0, sizeof(g_filter_info));
+	g_filter_info.id = kFilterId;
+	g_filter_info.type = OBS_SOURCE_TYPE_FILTER;
+	g_filter_info.output_flags = OBS_SOURCE_VIDEO;
+	g_filter_info.get_name = filter_name;
+	g_filter_info.create = filter_create;
+	g_filter_info.destroy = filter_destroy;
+	g_filter_info.update = filter_update;
+	g_filter_info.get_defaults = filter_defaults;
+	g_filter_info.get_properties = filter_properties;
+	g_filter_info.video_render = filter_render;
+	g_filter_info.video_tick = filter_video_tick;
+	g_filter_info.show = filter_show;
+	g_filter_info.hide = filter_hide;
+	obs_register_source(&g_filter_info);
+	BLOG(LOG_INFO, "Registered filter '%s'", kFilterId);
+}
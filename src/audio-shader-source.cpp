@@ -1,12 +1,9 @@
 #include "includes/audio-shader-source.hpp"
 
 #include <algorithm>
-#include <cctype>
-#include <cstdlib>
-#include <cmath>
-#include <complex>
 #include <cstring>
-#include <fstream>
+#include <ctime>
+#include <string>
 
 #include <util/platform.h>
 
@@ -14,225 +11,14 @@
 
 static const char *kSourceId = "audio_shader_engine_source";
 static const char *kSourceName = "Audio Shader Engine";
+static const char *kDefaultEffect = "effects/pulse-ring.effect";
 
-static const char *S_AUDIO_SOURCE = "audio_source";
 static const char *S_WIDTH = "width";
 static const char *S_HEIGHT = "height";
 static const char *S_USE_OBS_CANVAS = "use_obs_canvas";
-static const char *S_EFFECT_PATH = "effect_path";
-static const char *S_REACT_DB = "react_db";
-static const char *S_PEAK_DB = "peak_db";
-static const char *S_ATTACK_MS = "attack_ms";
-static const char *S_RELEASE_MS = "release_ms";
-static const char *S_FFT_SIZE = "fft_size";
-static const char *S_BAND_COUNT = "band_count";
-static const char *S_OPTION_PREFIX = "option";
-static const char *S_COLOR_PREFIX = "color";
 
 static obs_source_info g_source_info = {};
 
-static inline float clamp01(float v)
-{
-	return std::max(0.0f, std::min(1.0f, v));
-}
-
-static inline float amp_to_db(float amp)
-{
-	amp = std::max(amp, 0.000001f);
-	return 20.0f * std::log10(amp);
-}
-
-static inline float db_to_norm(float db, float react_db, float peak_db)
-{
-	if (peak_db <= react_db)
-		return 0.0f;
-	return clamp01((db - react_db) / (peak_db - react_db));
-}
-
-static inline float hash01(float n)
-{
-	return std::fmod(std::sin(n) * 43758.5453123f, 1.0f) < 0.0f
-		       ? std::fmod(std::sin(n) * 43758.5453123f, 1.0f) + 1.0f
-		       : std::fmod(std::sin(n) * 43758.5453123f, 1.0f);
-}
-
-static inline int clamp_pow2(int value, int min_value, int max_value)
-{
-	value = std::clamp(value, min_value, max_value);
-	int p = 1;
-	while (p < value)
-		p <<= 1;
-	int lower = p >> 1;
-	if (lower < min_value)
-		return p;
-	if (p > max_value)
-		return lower;
-	return (value - lower) < (p - value) ? lower : p;
-}
-
-static bool is_pow2(size_t n)
-{
-	return n >= 2 && (n & (n - 1)) == 0;
-}
-
-static void fft_inplace(std::vector<std::complex<float>> &a)
-{
-	const size_t n = a.size();
-	if (!is_pow2(n))
-		return;
-
-	for (size_t i = 1, j = 0; i < n; ++i) {
-		size_t bit = n >> 1;
-		for (; j & bit; bit >>= 1)
-			j ^= bit;
-		j ^= bit;
-		if (i < j)
-			std::swap(a[i], a[j]);
-	}
-
-	const float pi = 3.14159265358979323846f;
-	for (size_t len = 2; len <= n; len <<= 1) {
-		const float ang = -2.0f * pi / (float)len;
-		const std::complex<float> wlen(std::cos(ang), std::sin(ang));
-		for (size_t i = 0; i < n; i += len) {
-			std::complex<float> w(1.0f, 0.0f);
-			for (size_t j = 0; j < len / 2; ++j) {
-				const std::complex<float> u = a[i + j];
-				const std::complex<float> v = a[i + j + len / 2] * w;
-				a[i + j] = u + v;
-				a[i + j + len / 2] = u - v;
-				w *= wlen;
-			}
-		}
-	}
-}
-
-static void color_to_vec4(uint32_t color, vec4 *out)
-{
-	const float r = float(color & 0xFFu) / 255.0f;
-	const float g = float((color >> 8) & 0xFFu) / 255.0f;
-	const float b = float((color >> 16) & 0xFFu) / 255.0f;
-	vec4_set(out, r, g, b, 1.0f);
-}
-
-static std::string trim_copy(const std::string &v)
-{
-	size_t a = 0;
-	while (a < v.size() && std::isspace((unsigned char)v[a]))
-		++a;
-	size_t b = v.size();
-	while (b > a && std::isspace((unsigned char)v[b - 1]))
-		--b;
-	return v.substr(a, b - a);
-}
-
-struct effect_metadata {
-	std::string name;
-	std::array<std::string, 8> option_labels{};
-	std::array<std::string, 4> color_labels{};
-};
-
-static std::string default_effect_path_string()
-{
-	char *path = obs_module_file("effects/pulse-ring.effect");
-	if (!path)
-		return {};
-	std::string result = path;
-	bfree(path);
-	return result;
-}
-
-static effect_metadata load_effect_metadata(const std::string &effect_path)
-{
-	effect_metadata meta;
-	if (effect_path.empty())
-		return meta;
-
-	const std::string ini_path = effect_path + ".ini";
-	std::ifstream file(ini_path);
-	if (!file.is_open())
-		return meta;
-
-	std::string section;
-	std::string line;
-	while (std::getline(file, line)) {
-		line = trim_copy(line);
-		if (line.empty() || line[0] == '#' || line[0] == ';')
-			continue;
-		if (line.front() == '[' && line.back() == ']') {
-			section = trim_copy(line.substr(1, line.size() - 2));
-			std::transform(section.begin(), section.end(), section.begin(),
-				       [](unsigned char c) { return (char)std::tolower(c); });
-			continue;
-		}
-
-		const size_t eq = line.find('=');
-		if (eq == std::string::npos)
-			continue;
-
-		std::string key = trim_copy(line.substr(0, eq));
-		std::string value = trim_copy(line.substr(eq + 1));
-		if (value.empty())
-			continue;
-
-		if (section == "effect" && key == "name") {
-			meta.name = value;
-		} else if (section == "options" && key.rfind("option", 0) == 0) {
-			const int idx = std::atoi(key.c_str() + 6);
-			if (idx >= 1 && idx <= 8 && value.rfind("Custom Option", 0) != 0)
-				meta.option_labels[(size_t)idx - 1] = value;
-		} else if (section == "colors" && key.rfind("color", 0) == 0) {
-			const int idx = std::atoi(key.c_str() + 5);
-			if (idx >= 1 && idx <= 4)
-				meta.color_labels[(size_t)idx - 1] = value;
-		}
-	}
-
-	return meta;
-}
-
-static void rebuild_effect_controls(obs_properties_t *props, const std::string &effect_path)
-{
-	if (!props)
-		return;
-
-	obs_properties_remove_by_name(props, "shader_options");
-
-	effect_metadata meta = load_effect_metadata(effect_path);
-	obs_properties_t *shader_opts = obs_properties_create();
-	bool any_control = false;
-
-	for (int i = 1; i <= 8; ++i) {
-		const std::string &label = meta.option_labels[(size_t)i - 1];
-		if (label.empty())
-			continue;
-		char key[32];
-		snprintf(key, sizeof(key), "%s%d", S_OPTION_PREFIX, i);
-		obs_properties_add_float_slider(shader_opts, key, label.c_str(), 0.0, 1.0, 0.001);
-		any_control = true;
-	}
-
-	for (int i = 1; i <= 4; ++i) {
-		const std::string &label = meta.color_labels[(size_t)i - 1];
-		if (label.empty())
-			continue;
-		char key[32];
-		snprintf(key, sizeof(key), "%s%d", S_COLOR_PREFIX, i);
-		obs_properties_add_color(shader_opts, key, label.c_str());
-		any_control = true;
-	}
-
-	if (!any_control) {
-		obs_properties_add_text(
-			shader_opts, "no_effect_controls",
-			"This effect has no named controls. Add a matching .effect.ini file to expose sliders/colors.",
-			OBS_TEXT_INFO);
-	}
-
-	std::string group_name = meta.name.empty() ? "Effect Controls" : (meta.name + " Controls");
-	obs_properties_add_group(props, "shader_options", group_name.c_str(), OBS_GROUP_NORMAL, shader_opts);
-}
-
 static void get_obs_canvas_size(uint32_t *width, uint32_t *height)
 {
 	obs_video_info ovi = {};
@@ -273,279 +59,6 @@ static void set_source_dimensions(audio_shader_source *s, uint32_t width, uint32
 	BLOG(LOG_INFO, "Source canvas size changed to %ux%u", s->width, s->height);
 }
 
-static void release_audio_weak(audio_shader_source *s)
-{
-	if (!s || !s->audio_weak)
-		return;
-	obs_weak_source_release(s->audio_weak);
-	s->audio_weak = nullptr;
-}
-
-static void audio_capture_cb(void *param, obs_source_t *, const audio_data *audio, bool muted)
-{
-	auto *s = static_cast<audio_shader_source *>(param);
-	if (!s || !audio || !s->alive.load(std::memory_order_acquire))
-		return;
-
-	s->audio_cb_inflight.fetch_add(1, std::memory_order_acq_rel);
-
-	if (muted || audio->frames == 0 || !audio->data[0]) {
-		if (muted && audio && audio->frames > 0) {
-			std::lock_guard<std::mutex> lock(s->audio_mutex);
-			const size_t n = s->mono_ring.size();
-			if (n > 0) {
-				const size_t fill = std::min(static_cast<size_t>(audio->frames), n);
-				for (size_t i = 0; i < fill; ++i) {
-					s->mono_ring[s->mono_pos] = 0.0f;
-					s->mono_pos = (s->mono_pos + 1) % n;
-					if (s->mono_count < n)
-						++s->mono_count;
-				}
-			}
-			s->raw_level = 0.0f;
-			s->raw_peak = 0.0f;
-		}
-		s->audio_cb_inflight.fetch_sub(1, std::memory_order_acq_rel);
-		return;
-	}
-
-	const size_t frames = audio->frames;
-	const float *left = reinterpret_cast<const float *>(audio->data[0]);
-	const float *right = audio->data[1] ? reinterpret_cast<const float *>(audio->data[1]) : nullptr;
-
-	float sum_sq = 0.0f;
-	float peak = 0.0f;
-
-	std::lock_guard<std::mutex> lock(s->audio_mutex);
-	if ((int)s->mono_ring.size() != s->fft_size) {
-		s->mono_ring.assign((size_t)s->fft_size, 0.0f);
-		s->mono_pos = 0;
-		s->mono_count = 0;
-	}
-
-	for (size_t i = 0; i < frames; ++i) {
-		const float l = left[i];
-		const float r = right ? right[i] : l;
-		const float mono = 0.5f * (l + r);
-		sum_sq += mono * mono;
-		peak = std::max(peak, std::fabs(mono));
-
-		s->mono_ring[s->mono_pos] = mono;
-		s->mono_pos = (s->mono_pos + 1) % s->mono_ring.size();
-		if (s->mono_count < s->mono_ring.size())
-			++s->mono_count;
-	}
-
-	s->raw_level = std::sqrt(sum_sq / std::max<size_t>(1, frames));
-	s->raw_peak = peak;
-
-	s->audio_cb_inflight.fetch_sub(1, std::memory_order_acq_rel);
-}
-
-static void detach_audio(audio_shader_source *s)
-{
-	if (!s || !s->audio_weak)
-		return;
-
-	obs_source_t *target = obs_weak_source_get_source(s->audio_weak);
-	if (target) {
-		obs_source_remove_audio_capture_callback(target, audio_capture_cb, s);
-		obs_source_release(target);
-	}
-	release_audio_weak(s);
-}
-
-static void attach_audio(audio_shader_source *s)
-{
-	if (!s || s->audio_source_name.empty())
-		return;
-
-	obs_source_t *target = obs_get_source_by_name(s->audio_source_name.c_str());
-	if (!target) {
-		BLOG(LOG_WARNING, "Audio source '%s' not found", s->audio_source_name.c_str());
-		return;
-	}
-
-	s->audio_weak = obs_source_get_weak_source(target);
-	obs_source_add_audio_capture_callback(target, audio_capture_cb, s);
-	obs_source_release(target);
-}
-
-static bool enum_audio_sources(void *data, obs_source_t *source)
-{
-	obs_property_t *prop = static_cast<obs_property_t *>(data);
-	const char *id = obs_source_get_id(source);
-	if (id && std::strcmp(id, kSourceId) == 0)
-		return true;
-	if (!obs_source_audio_active(source))
-		return true;
-	const char *name = obs_source_get_name(source);
-	if (name)
-		obs_property_list_add_string(prop, name, name);
-	return true;
-}
-
-static void calculate_audio_state(audio_shader_source *s)
-{
-	float raw_level = 0.0f;
-	float raw_peak = 0.0f;
-	std::vector<float> ring;
-	size_t pos = 0;
-	size_t count = 0;
-
-	{
-		std::lock_guard<std::mutex> lock(s->audio_mutex);
-		raw_level = s->raw_level;
-		raw_peak = s->raw_peak;
-		ring = s->mono_ring;
-		pos = s->mono_pos;
-		count = s->mono_count;
-	}
-
-	const float target_level = db_to_norm(amp_to_db(raw_level), s->react_db, s->peak_db);
-	const float target_peak = db_to_norm(amp_to_db(raw_peak), s->react_db, s->peak_db);
-
-	const uint64_t now = os_gettime_ns();
-	float dt = 1.0f / 60.0f;
-	if (s->last_ts_ns != 0 && now > s->last_ts_ns)
-		dt = float(double(now - s->last_ts_ns) / 1000000000.0);
-	s->last_ts_ns = now;
-
-	auto smooth = [dt](float current, float target, float attack_ms, float release_ms) {
-		const float tau = (target > current ? attack_ms : release_ms) / 1000.0f;
-		if (tau <= 0.000001f)
-			return target;
-		const float a = 1.0f - std::exp(-dt / tau);
-		return current + (target - current) * a;
-	};
-
-	s->level = clamp01(smooth(s->level, target_level, s->attack_ms, s->release_ms));
-	s->peak = clamp01(smooth(s->peak, target_peak, s->attack_ms * 0.5f, s->release_ms * 1.5f));
-
-	std::array<float, 64> raw_bands{};
-	s->bass = s->mid = s->treble = 0.0f;
-	if (ring.empty() || count < ring.size() / 2) {
-		for (float &band : s->bands)
-			band = clamp01(smooth(band, 0.0f, s->attack_ms, s->release_ms));
-		return;
-	}
-
-	const size_t n = ring.size();
-	std::vector<std::complex<float>> fft(n);
-	for (size_t i = 0; i < n; ++i) {
-		const size_t idx = (pos + i) % n;
-		const float Hann = 0.5f - 0.5f * std::cos(2.0f * 3.14159265358979323846f * float(i) / float(n - 1));
-		fft[i] = std::complex<float>(ring[idx] * Hann, 0.0f);
-	}
-	fft_inplace(fft);
-
-	const int usable_bins = int(n / 2);
-	const int bands = std::clamp(s->band_count, 1, 64);
-	for (int b = 0; b < bands; ++b) {
-		const float t0 = float(b) / float(bands);
-		const float t1 = float(b + 1) / float(bands);
-		const int bin0 = std::max(1, int(std::pow(t0, 2.0f) * usable_bins));
-		const int bin1 = std::max(bin0 + 1, int(std::pow(t1, 2.0f) * usable_bins));
-		float mag = 0.0f;
-		int c = 0;
-		for (int bin = bin0; bin < std::min(bin1, usable_bins); ++bin) {
-			mag += std::abs(fft[(size_t)bin]);
-			++c;
-		}
-		mag = c > 0 ? mag / float(c) : 0.0f;
-		raw_bands[(size_t)b] = db_to_norm(amp_to_db(mag / float(n)), s->react_db, s->peak_db);
-	}
-
-	auto avg_raw_range = [&](int a, int b) {
-		float sum = 0.0f;
-		int c = 0;
-		for (int i = std::max(0, a); i < b && i < bands; ++i) {
-			sum += raw_bands[(size_t)i];
-			++c;
-		}
-		return c ? sum / float(c) : 0.0f;
-	};
-
-	const float raw_bass = avg_raw_range(0, std::max(1, bands / 4));
-	const float raw_mid = avg_raw_range(std::max(1, bands / 4), std::max(2, bands * 2 / 3));
-	const float raw_treble = avg_raw_range(std::max(2, bands * 2 / 3), bands);
-
-	s->bass = clamp01(smooth(s->bass, raw_bass, s->attack_ms, s->release_ms));
-	s->mid = clamp01(smooth(s->mid, raw_mid, s->attack_ms, s->release_ms));
-	s->treble = clamp01(smooth(s->treble, raw_treble, s->attack_ms, s->release_ms));
-
-
-	std::array<float, 64> target_cells{};
-	std::array<bool, 64> used_bands{};
-
-	const float time_bucket = std::floor(float(now / 1000000000.0) * 3.0f);
-	const int peak_slots = std::min(14, bands);
-
-	for (int slot = 0; slot < peak_slots; ++slot) {
-		int best = -1;
-		float best_score = 0.0f;
-
-		for (int b = 0; b < bands; ++b) {
-			if (used_bands[(size_t)b])
-				continue;
-
-			const float left = raw_bands[(size_t)std::max(0, b - 1)];
-			const float right = raw_bands[(size_t)std::min(bands - 1, b + 1)];
-			const float local_contrast = std::max(0.0f, raw_bands[(size_t)b] - (left + right) * 0.35f);
-			const float score = raw_bands[(size_t)b] * 0.70f + local_contrast * 0.85f;
-
-			if (score > best_score) {
-				best_score = score;
-				best = b;
-			}
-		}
-
-		if (best < 0 || best_score <= 0.001f)
-			break;
-
-		used_bands[(size_t)best] = true;
-		if (best > 0)
-			used_bands[(size_t)best - 1] = true;
-		if (best + 1 < bands)
-			used_bands[(size_t)best + 1] = true;
-
-		const float h = hash01(float(best) * 19.731f + float(slot) * 7.113f + time_bucket * 0.173f);
-		const int center = std::clamp((int)std::floor(h * 64.0f), 0, 63);
-		const float gain = 0.72f + hash01(float(best) * 5.371f + float(slot) * 31.91f) * 0.55f;
-		const float amp = clamp01(raw_bands[(size_t)best] * gain * (0.65f + s->peak * 0.55f));
-		const int radius = 2 + (hash01(float(best) * 11.17f + float(slot) * 3.31f) > 0.62f ? 1 : 0);
-
-		for (int off = -radius; off <= radius; ++off) {
-			int idx = center + off;
-			while (idx < 0)
-				idx += 64;
-			while (idx >= 64)
-				idx -= 64;
-
-			const float d = std::fabs(float(off));
-			float falloff = 1.0f;
-			if (d >= 1.0f)
-				falloff = d < 2.0f ? 0.52f : (d < 3.0f ? 0.24f : 0.10f);
-
-			target_cells[(size_t)idx] = std::max(target_cells[(size_t)idx], amp * falloff);
-		}
-	}
-
-	const float floor_energy = s->level * 0.025f;
-	for (size_t i = 0; i < s->bands.size(); ++i) {
-		const float target = clamp01(std::max(target_cells[i], floor_energy));
-		s->bands[i] = clamp01(smooth(s->bands[i], target, s->attack_ms, s->release_ms));
-	}
-}
-
-static void destroy_effect(audio_shader_source *s)
-{
-	if (s && s->effect) {
-		gs_effect_destroy(s->effect);
-		s->effect = nullptr;
-	}
-}
-
 static void destroy_texrender(audio_shader_source *s)
 {
 	if (s && s->texrender) {
@@ -554,194 +67,67 @@ static void destroy_texrender(audio_shader_source *s)
 	}
 }
 
-static void destroy_band_texture(audio_shader_source *s)
+static void draw_fullscreen_quad(uint32_t width, uint32_t height)
 {
-	if (s && s->band_texture) {
-		gs_texture_destroy(s->band_texture);
-		s->band_texture = nullptr;
-	}
+	gs_draw_sprite(nullptr, 0, width, height);
 }
 
-static void load_effect_if_needed(audio_shader_source *s)
+// Runs the analysis step and renders the selected effect into texrender at
+// the governor's current render scale.
+static bool render_effect_to_texture(audio_shader_source *s)
 {
-	if (!s || !s->reload_effect)
-		return;
-
-	s->reload_effect = false;
-	destroy_effect(s);
-	s->effect_error.clear();
-
-	if (s->effect_path.empty()) {
-		BLOG(LOG_WARNING, "No .effect file selected");
-		return;
-	}
-
-	BLOG(LOG_INFO, "Loading effect: %s", s->effect_path.c_str());
-	char *error = nullptr;
-	s->effect = gs_effect_create_from_file(s->effect_path.c_str(), &error);
-	if (!s->effect) {
-		s->effect_error = error ? error : "Unknown shader compile error";
-		BLOG(LOG_ERROR, "Could not load effect '%s': %s", s->effect_path.c_str(), s->effect_error.c_str());
-	} else {
-		BLOG(LOG_INFO, "Effect loaded successfully: %s", s->effect_path.c_str());
-	}
-	if (error)
-		bfree(error);
-}
-
-static void set_float_param(gs_effect_t *effect, const char *name, float value)
-{
-	if (gs_eparam_t *p = gs_effect_get_param_by_name(effect, name))
-		gs_effect_set_float(p, value);
-}
-
-static void set_vec2_param(gs_effect_t *effect, const char *name, float x, float y)
-{
-	if (gs_eparam_t *p = gs_effect_get_param_by_name(effect, name)) {
-		vec2 v;
-		vec2_set(&v, x, y);
-		gs_effect_set_vec2(p, &v);
-	}
-}
-
-static void set_color_param(gs_effect_t *effect, const char *name, uint32_t color)
-{
-	if (gs_eparam_t *p = gs_effect_get_param_by_name(effect, name)) {
-		vec4 v;
-		color_to_vec4(color, &v);
-		gs_effect_set_vec4(p, &v);
-	}
-}
-
-static void update_band_texture(audio_shader_source *s)
-{
-	if (!s)
-		return;
-
-	for (size_t i = 0; i < s->bands.size(); ++i) {
-		const size_t px = i * 4;
-		s->band_texture_pixels[px + 0] = uint8_t(clamp01(s->bands[i]) * 255.0f + 0.5f);
-		s->band_texture_pixels[px + 1] = uint8_t(clamp01(s->bass) * 255.0f + 0.5f);
-		s->band_texture_pixels[px + 2] = uint8_t(clamp01(s->mid) * 255.0f + 0.5f);
-		s->band_texture_pixels[px + 3] = uint8_t(clamp01(s->treble) * 255.0f + 0.5f);
-	}
-
-	if (!s->band_texture) {
-		const uint8_t *data[] = {s->band_texture_pixels.data()};
-		s->band_texture = gs_texture_create(64, 1, GS_RGBA, 1, data, GS_DYNAMIC);
-		if (!s->band_texture) {
-			BLOG(LOG_ERROR, "Failed to create FFT band texture for source '%s'",
-			     obs_source_get_name(s->self));
-			return;
-		}
-	} else {
-		gs_texture_set_image(s->band_texture, s->band_texture_pixels.data(), 64 * 4, false);
-	}
-}
+	if (!audio_analyzer_wait(&s->analyzer))
+		audio_analyzer_tick(&s->analyzer, os_gettime_ns());
+	shader_effect_update_band_texture(&s->shader, s->analyzer, s->self);
+	shader_effect_load_if_needed(&s->shader);
 
-static void set_texture_param(gs_effect_t *effect, const char *name, gs_texture_t *texture)
-{
-	if (!texture)
-		return;
-	if (gs_eparam_t *p = gs_effect_get_param_by_name(effect, name))
-		gs_effect_set_texture(p, texture);
-}
-
-static void set_shader_params(audio_shader_source *s)
-{
-	gs_effect_t *e = s->effect;
-	if (!e)
-		return;
-
-	set_vec2_param(e, "source_size", float(s->width), float(s->height));
-	set_vec2_param(e, "resolution", float(s->width), float(s->height));
-	set_float_param(e, "time", float(os_gettime_ns() / 1000000000.0));
-	set_float_param(e, "audio_level", s->level);
-	set_float_param(e, "audio_peak", s->peak);
-	set_float_param(e, "audio_bass", s->bass);
-	set_float_param(e, "audio_mid", s->mid);
-	set_float_param(e, "audio_treble", s->treble);
-	set_float_param(e, "band_count", float(s->band_count));
-
-	set_texture_param(e, "audio_band_texture", s->band_texture);
-	set_texture_param(e, "audio_spectrum_texture", s->band_texture);
-
-	for (size_t i = 0; i < s->options.size(); ++i) {
-		char name[32];
-		snprintf(name, sizeof(name), "option%zu", i + 1);
-		set_float_param(e, name, s->options[i]);
-	}
-	for (size_t i = 0; i < s->colors.size(); ++i) {
-		char name[32];
-		snprintf(name, sizeof(name), "color%zu", i + 1);
-		set_color_param(e, name, s->colors[i]);
-	}
-}
-
-static void draw_fullscreen_quad(audio_shader_source *s)
-{
-	gs_draw_sprite(nullptr, 0, s->width, s->height);
-}
-
-static void source_render(void *data, gs_effect_t *)
-{
-	auto *s = static_cast<audio_shader_source *>(data);
-	if (!s)
-		return;
-
-	std::lock_guard<std::mutex> lock(s->render_mutex);
-
-	if (!s->alive.load(std::memory_order_acquire))
-		return;
+	// Automatic quality starts from the canvas size and the governor may
+	// lower it further; a manual tier is left alone.
+	const int tier = shader_effect_auto_tier(&s->shader, s->width, s->height);
+	const int drop = render_governor_quality_drop(&s->governor, std::max(0, tier - 1));
+	shader_effect_select_tier(&s->shader, tier > 0 ? tier - drop : 0);
 
-	if (!s->texrender) {
-		s->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
-		if (!s->texrender) {
-			BLOG(LOG_ERROR, "Failed to create texrender for source '%s'", obs_source_get_name(s->self));
-			return;
-		}
-	}
+	uint32_t rw = s->width;
+	uint32_t rh = s->height;
+	render_governor_scaled_size(&s->governor, s->width, s->height, &rw, &rh);
 
-	calculate_audio_state(s);
-	update_band_texture(s);
-	load_effect_if_needed(s);
+	AW_TRACE_SCOPE("effect_draw", uint64_t(rw) * rh);
 
-	if (!s->effect) {
+	if (!s->shader.effect) {
 		if (!s->render_logged_no_effect) {
 			BLOG(LOG_WARNING, "Source '%s' has no loaded effect. Selected path='%s'",
-			     obs_source_get_name(s->self), s->effect_path.c_str());
+			     obs_source_get_name(s->self), s->shader.effect_path.c_str());
 			s->render_logged_no_effect = true;
 		}
-		return;
+		return false;
 	}
 
-	gs_technique_t *tech = gs_effect_get_technique(s->effect, "Draw");
-	if (!tech)
-		tech = gs_effect_get_technique(s->effect, "Solid");
-	if (!tech)
-		tech = gs_effect_get_technique(s->effect, "Default");
+	gs_technique_t *tech = shader_effect_technique(&s->shader);
 	if (!tech) {
 		if (!s->render_logged_no_technique) {
-			BLOG(LOG_ERROR, "Effect '%s' has no Draw, Solid, or Default technique", s->effect_path.c_str());
+			BLOG(LOG_ERROR, "Effect '%s' has no Draw, Solid, or Default technique",
+			     s->shader.effect_path.c_str());
 			s->render_logged_no_technique = true;
 		}
-		return;
+		return false;
 	}
 
-	set_shader_params(s);
+	shader_effect_set_params(&s->shader, s->analyzer, rw, rh);
 
 	gs_texrender_reset(s->texrender);
-	if (!gs_texrender_begin(s->texrender, (int)s->width, (int)s->height)) {
+	if (!gs_texrender_begin(s->texrender, (int)rw, (int)rh)) {
 		BLOG(LOG_WARNING, "gs_texrender_begin failed for source '%s'", obs_source_get_name(s->self));
-		return;
+		return false;
 	}
 
+	render_governor_begin(&s->governor);
+
 	vec4 clear_color = {};
 	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
 
 	gs_projection_push();
 	gs_matrix_push();
-	gs_ortho(0.0f, (float)s->width, 0.0f, (float)s->height, -100.0f, 100.0f);
+	gs_ortho(0.0f, (float)rw, 0.0f, (float)rh, -100.0f, 100.0f);
 
 	gs_blend_state_push();
 	gs_reset_blend_state();
@@ -751,7 +137,7 @@ static void source_render(void *data, gs_effect_t *)
 	const size_t passes = gs_technique_begin(tech);
 	for (size_t i = 0; i < passes; ++i) {
 		gs_technique_begin_pass(tech, i);
-		draw_fullscreen_quad(s);
+		draw_fullscreen_quad(rw, rh);
 		gs_technique_end_pass(tech);
 	}
 	gs_technique_end(tech);
@@ -761,6 +147,47 @@ static void source_render(void *data, gs_effect_t *)
 	gs_projection_pop();
 	gs_texrender_end(s->texrender);
 
+	render_governor_end(&s->governor, s->self);
+	return true;
+}
+
+static void render_source(audio_shader_source *s)
+{
+	std::lock_guard<std::mutex> lock(s->render_mutex);
+
+	if (!s->analyzer.alive.load(std::memory_order_acquire))
+		return;
+
+	if (!s->texrender) {
+		s->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		if (!s->texrender) {
+			BLOG(LOG_ERROR, "Failed to create texrender for source '%s'", obs_source_get_name(s->self));
+			return;
+		}
+	}
+
+	// Program, preview, multiview and projectors may all draw this source in
+	// the same video frame. Only the first draw analyzes and renders; the
+	// rest reuse that texture, so smoothing is not advanced by a tiny dt.
+	// When the governor has lowered the shader rate, whole video frames reuse
+	// the previous texture as well.
+	const uint64_t frame_ts = obs_get_video_frame_time();
+	const bool have_texture = s->rendered_frame_ts != 0 && s->rendered_width == s->width &&
+				  s->rendered_height == s->height && !s->shader.reload_effect;
+	bool reuse = have_texture && frame_ts != 0 && frame_ts == s->rendered_frame_ts;
+	if (have_texture && !reuse && !render_governor_should_render(&s->governor)) {
+		s->rendered_frame_ts = frame_ts;
+		reuse = true;
+	}
+	if (!reuse) {
+		s->rendered_frame_ts = 0;
+		if (!render_effect_to_texture(s))
+			return;
+		s->rendered_frame_ts = frame_ts;
+		s->rendered_width = s->width;
+		s->rendered_height = s->height;
+	}
+
 	gs_texture_t *tex = gs_texrender_get_texture(s->texrender);
 	if (!tex)
 		return;
@@ -783,13 +210,28 @@ static void source_render(void *data, gs_effect_t *)
 
 	if (!s->render_logged_ok || s->logged_width != s->width || s->logged_height != s->height) {
 		BLOG(LOG_INFO, "Rendering source '%s' with effect '%s' at %ux%u", obs_source_get_name(s->self),
-		     s->effect_path.c_str(), s->width, s->height);
+		     s->shader.effect_path.c_str(), s->width, s->height);
 		s->render_logged_ok = true;
 		s->logged_width = s->width;
 		s->logged_height = s->height;
 	}
 }
 
+static void source_render(void *data, gs_effect_t *)
+{
+	auto *s = static_cast<audio_shader_source *>(data);
+	if (!s)
+		return;
+
+	AW_TRACE_SCOPE("source_render");
+	const uint64_t probe_t0 = AW_PROBE_CLOCK(source_render_exit);
+	AW_PROBE3(source_render_entry, aw_probe_id(s->self), s->width, s->height);
+
+	render_source(s);
+
+	AW_PROBE2(source_render_exit, aw_probe_id(s->self), aw_probe_elapsed(probe_t0));
+}
+
 static uint32_t source_width(void *data)
 {
 	auto *s = static_cast<audio_shader_source *>(data);
@@ -821,9 +263,9 @@ static bool use_canvas_modified(obs_properties_t *props, obs_property_t *, obs_d
 
 static bool effect_path_modified(obs_properties_t *props, obs_property_t *, obs_data_t *settings)
 {
-	const char *path = obs_data_get_string(settings, S_EFFECT_PATH);
-	std::string effect_path = path && *path ? path : default_effect_path_string();
-	rebuild_effect_controls(props, effect_path);
+	const char *path = shader_effect_settings_path(settings);
+	std::string effect_path = path && *path ? path : shader_effect_module_path(kDefaultEffect);
+	shader_effect_rebuild_controls(props, effect_path);
 	return true;
 }
 
@@ -836,30 +278,49 @@ static bool reload_effect_clicked(obs_properties_t *props, obs_property_t *, voi
 		return false;
 
 	std::lock_guard<std::mutex> lock(s->render_mutex);
-	s->reload_effect = true;
+	shader_effect_request_recompile(&s->shader);
 	s->render_logged_ok = false;
 	s->render_logged_no_effect = false;
 	s->render_logged_no_technique = false;
-	s->effect_error.clear();
 
 	BLOG(LOG_INFO, "Manual shader reload queued for '%s'", obs_source_get_name(s->self));
 	return true;
 }
 
+static const char *trace_button_label()
+{
+	return pipeline_trace_enabled() ? "Stop Pipeline Trace and Save" : "Start Pipeline Trace";
+}
+
+static bool trace_toggle_clicked(obs_properties_t *, obs_property_t *property, void *)
+{
+	if (!pipeline_trace_enabled()) {
+		pipeline_trace_set_enabled(true);
+	} else {
+		pipeline_trace_set_enabled(false);
+
+		char *dir = obs_module_config_path("traces");
+		if (dir) {
+			os_mkdirs(dir);
+			const std::string path = std::string(dir) + "/pipeline-" + std::to_string(time(nullptr)) + ".json";
+			pipeline_trace_write(path.c_str());
+			bfree(dir);
+		}
+	}
+
+	obs_property_set_description(property, trace_button_label());
+	return true;
+}
+
 static obs_properties_t *source_properties(void *data)
 {
 	auto *s = static_cast<audio_shader_source *>(data);
 	obs_properties_t *props = obs_properties_create();
 	obs_properties_set_param(props, s, nullptr);
 
-	obs_property_t *audio = obs_properties_add_list(props, S_AUDIO_SOURCE, "Audio Source", OBS_COMBO_TYPE_LIST,
-							OBS_COMBO_FORMAT_STRING);
-	obs_enum_sources(enum_audio_sources, audio);
+	audio_analyzer_add_source_list(props);
 
-	obs_property_t *effect_path = obs_properties_add_path(props, S_EFFECT_PATH, "HLSL / OBS .effect file",
-							      OBS_PATH_FILE, "OBS Effect (*.effect);;All files (*.*)",
-							      nullptr);
-	obs_property_set_modified_callback(effect_path, effect_path_modified);
+	shader_effect_add_path_property(props, effect_path_modified);
 
 	obs_properties_add_button(props, "reload_shader", "\xe2\x86\xba  Reload Shader", reload_effect_clicked);
 
@@ -873,33 +334,21 @@ static obs_properties_t *source_properties(void *data)
 	obs_properties_add_int(props, S_WIDTH, "Manual Canvas Width", 16, 8192, 1);
 	obs_properties_add_int(props, S_HEIGHT, "Manual Canvas Height", 16, 8192, 1);
 
-	obs_properties_add_float_slider(props, S_REACT_DB, "React at dB", -90.0, -1.0, 1.0);
-	obs_properties_add_float_slider(props, S_PEAK_DB, "Peak at dB", -60.0, 0.0, 1.0);
-	obs_properties_add_int_slider(props, S_ATTACK_MS, "Attack ms", 0, 500, 1);
-	obs_properties_add_int_slider(props, S_RELEASE_MS, "Release ms", 0, 2000, 1);
+	audio_analyzer_add_properties(props, s ? &s->analyzer : nullptr);
+	render_governor_add_properties(props, s ? &s->governor : nullptr);
 
-	obs_property_t *fft =
-		obs_properties_add_list(props, S_FFT_SIZE, "FFT Size", OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
-	obs_property_list_add_int(fft, "512", 512);
-	obs_property_list_add_int(fft, "1024", 1024);
-	obs_property_list_add_int(fft, "2048", 2048);
-	obs_property_list_add_int(fft, "4096", 4096);
-	obs_property_list_add_int(fft, "8192", 8192);
-	obs_properties_add_int_slider(props, S_BAND_COUNT, "Shader Bands", 8, 64, 1);
+	obs_properties_add_button(props, "pipeline_trace", trace_button_label(), trace_toggle_clicked);
 
-	std::string meta_effect_path = s && !s->effect_path.empty() ? s->effect_path : default_effect_path_string();
-	rebuild_effect_controls(props, meta_effect_path);
+	std::string meta_effect_path = s && !s->shader.effect_path.empty() ? s->shader.effect_path
+									    : shader_effect_module_path(kDefaultEffect);
+	shader_effect_rebuild_controls(props, meta_effect_path);
 
 	return props;
 }
 
 static void source_defaults(obs_data_t *settings)
 {
-	char *default_effect = obs_module_file("effects/pulse-ring.effect");
-	if (default_effect) {
-		obs_data_set_default_string(settings, S_EFFECT_PATH, default_effect);
-		bfree(default_effect);
-	}
+	shader_effect_defaults(settings, kDefaultEffect);
 
 	uint32_t canvas_w = 1920;
 	uint32_t canvas_h = 1080;
@@ -907,16 +356,8 @@ static void source_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, S_USE_OBS_CANVAS, false);
 	obs_data_set_default_int(settings, S_WIDTH, 400);
 	obs_data_set_default_int(settings, S_HEIGHT, 400);
-	obs_data_set_default_double(settings, S_REACT_DB, -55.0);
-	obs_data_set_default_double(settings, S_PEAK_DB, -6.0);
-	obs_data_set_default_int(settings, S_ATTACK_MS, 25);
-	obs_data_set_default_int(settings, S_RELEASE_MS, 180);
-	obs_data_set_default_int(settings, S_FFT_SIZE, 2048);
-	obs_data_set_default_int(settings, S_BAND_COUNT, 64);
-	obs_data_set_default_int(settings, "color1", 0xFFFFFF);
-	obs_data_set_default_int(settings, "color2", 0xFFD200);
-	obs_data_set_default_int(settings, "color3", 0xBB509D);
-	obs_data_set_default_int(settings, "color4", 0xAC3CFF);
+	audio_analyzer_defaults(settings);
+	render_governor_defaults(settings);
 }
 
 static void source_update(void *data, obs_data_t *settings)
@@ -925,11 +366,12 @@ static void source_update(void *data, obs_data_t *settings)
 	if (!s)
 		return;
 
-	detach_audio(s);
+	audio_analyzer_detach(&s->analyzer);
 
 	std::lock_guard<std::mutex> lock(s->render_mutex);
 
-	s->audio_source_name = obs_data_get_string(settings, S_AUDIO_SOURCE);
+	audio_analyzer_update_settings(&s->analyzer, settings);
+	render_governor_update_settings(&s->governor, settings);
 	s->use_obs_canvas = obs_data_get_bool(settings, S_USE_OBS_CANVAS);
 
 	uint32_t next_width = 1920;
@@ -941,44 +383,17 @@ static void source_update(void *data, obs_data_t *settings)
 		next_height = valid_dimension(obs_data_get_int(settings, S_HEIGHT), s->height ? s->height : 1080);
 	}
 	set_source_dimensions(s, next_width, next_height);
-	s->react_db = float(obs_data_get_double(settings, S_REACT_DB));
-	s->peak_db = float(obs_data_get_double(settings, S_PEAK_DB));
-	s->attack_ms = float(obs_data_get_int(settings, S_ATTACK_MS));
-	s->release_ms = float(obs_data_get_int(settings, S_RELEASE_MS));
-	s->fft_size = clamp_pow2((int)obs_data_get_int(settings, S_FFT_SIZE), 512, 8192);
-	s->band_count = std::clamp<int>((int)obs_data_get_int(settings, S_BAND_COUNT), 1, 64);
-
-	const char *new_effect = obs_data_get_string(settings, S_EFFECT_PATH);
-	std::string next_path = new_effect ? new_effect : "";
-	if (next_path != s->effect_path) {
-		s->effect_path = next_path;
-		s->reload_effect = true;
+
+	if (shader_effect_update_settings(&s->shader, settings)) {
 		s->render_logged_ok = false;
 		s->render_logged_no_effect = false;
 		s->render_logged_no_technique = false;
 	}
 
-	for (int i = 1; i <= 8; ++i) {
-		char key[32];
-		snprintf(key, sizeof(key), "%s%d", S_OPTION_PREFIX, i);
-		s->options[(size_t)i - 1] = float(obs_data_get_double(settings, key));
-	}
-	for (int i = 1; i <= 4; ++i) {
-		char key[32];
-		snprintf(key, sizeof(key), "%s%d", S_COLOR_PREFIX, i);
-		s->colors[(size_t)i - 1] = uint32_t(obs_data_get_int(settings, key)) & 0xFFFFFFu;
-	}
-
-	{
-		std::lock_guard<std::mutex> audio_lock(s->audio_mutex);
-		if ((int)s->mono_ring.size() != s->fft_size) {
-			s->mono_ring.assign((size_t)s->fft_size, 0.0f);
-			s->mono_pos = 0;
-			s->mono_count = 0;
-		}
-	}
-
-	attach_audio(s);
+	// Audio is only captured while the source is shown; source_show() binds
+	// it the first time, so loading a scene collection attaches nothing.
+	if (obs_source_showing(s->self))
+		audio_analyzer_attach(&s->analyzer);
 }
 
 static void *source_create(obs_data_t *settings, obs_source_t *source)
@@ -988,17 +403,10 @@ static void *source_create(obs_data_t *settings, obs_source_t *source)
 		return nullptr;
 
 	s->self = source;
-	obs_audio_info ai;
-	if (obs_get_audio_info(&ai) && ai.samples_per_sec > 0)
-		s->sample_rate = int(ai.samples_per_sec);
-
-	obs_enter_graphics();
-	s->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
-	obs_leave_graphics();
-
-	if (!s->texrender)
-		BLOG(LOG_WARNING, "Could not create texrender at source_create; will retry on first render");
+	audio_analyzer_init(&s->analyzer, source);
 
+	// GPU objects (texrender, effect, band texture, timers) are created on
+	// first render, so sources that are never shown cost no graphics work.
 	source_update(s, settings);
 	return s;
 }
@@ -1009,30 +417,21 @@ static void source_destroy(void *data)
 	if (!s)
 		return;
 
-	s->alive.store(false, std::memory_order_release);
-
-	detach_audio(s);
-
-	for (int i = 0; i < 2000; ++i) {
-		if (s->audio_cb_inflight.load(std::memory_order_acquire) == 0)
-			break;
-		os_sleep_ms(1);
-	}
+	audio_analyzer_shutdown(&s->analyzer);
 
 	obs_enter_graphics();
-	destroy_effect(s);
+	shader_effect_destroy(&s->shader);
+	render_governor_destroy(&s->governor);
 	destroy_texrender(s);
-	destroy_band_texture(s);
 	obs_leave_graphics();
 
-	release_audio_weak(s);
 	delete s;
 }
 
 static void source_video_tick(void *data, float)
 {
 	auto *s = static_cast<audio_shader_source *>(data);
-	if (!s || !s->use_obs_canvas)
+	if (!s)
 		return;
 
 	uint32_t canvas_w = 1920;
@@ -1040,21 +439,26 @@ static void source_video_tick(void *data, float)
 	get_obs_canvas_size(&canvas_w, &canvas_h);
 
 	std::lock_guard<std::mutex> lock(s->render_mutex);
-	set_source_dimensions(s, canvas_w, canvas_h);
+	if (s->use_obs_canvas)
+		set_source_dimensions(s, canvas_w, canvas_h);
+
+	// Start this frame's analysis on the pool; render picks up the result.
+	if (obs_source_showing(s->self))
+		audio_analyzer_tick_async(&s->analyzer, os_gettime_ns());
 }
 
 static void source_show(void *data)
 {
 	auto *s = static_cast<audio_shader_source *>(data);
-	if (s) {
-		detach_audio(s);
-		attach_audio(s);
-	}
+	if (s)
+		audio_analyzer_attach(&s->analyzer);
 }
 
 static void source_hide(void *data)
 {
-	detach_audio(static_cast<audio_shader_source *>(data));
+	auto *s = static_cast<audio_shader_source *>(data);
+	if (s)
+		audio_analyzer_detach(&s->analyzer);
 }
 
 extern "C" void register_audio_shader_source(void)
@@ -0,0 +1,204 @@
+#include "includes/audio-source-index.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+struct audio_source_entry {
+	std::string uuid;
+	std::string name;
+	bool audio_active = false;
+};
+
+static std::mutex g_index_mutex;
+static std::vector<audio_source_entry> g_index;
+static bool g_index_started = false;
+
+static bool is_audio_input(obs_source_t *source)
+{
+	return source && obs_source_get_type(source) == OBS_SOURCE_TYPE_INPUT &&
+	       (obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO);
+}
+
+// Must be called with g_index_mutex held.
+static audio_source_entry *find_locked(const char *uuid)
+{
+	if (!uuid)
+		return nullptr;
+	for (audio_source_entry &entry : g_index) {
+		if (entry.uuid == uuid)
+			return &entry;
+	}
+	return nullptr;
+}
+
+static void add_source(obs_source_t *source)
+{
+	if (!is_audio_input(source))
+		return;
+
+	const char *uuid = obs_source_get_uuid(source);
+	const char *name = obs_source_get_name(source);
+	if (!uuid || !*uuid)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	audio_source_entry *entry = find_locked(uuid);
+	if (!entry) {
+		g_index.emplace_back();
+		entry = &g_index.back();
+		entry->uuid = uuid;
+	}
+	entry->name = name ? name : "";
+	entry->audio_active = obs_source_audio_active(source);
+}
+
+static obs_source_t *signal_source(calldata_t *cd)
+{
+	return static_cast<obs_source_t *>(calldata_ptr(cd, "source"));
+}
+
+static void on_source_create(void *, calldata_t *cd)
+{
+	add_source(signal_source(cd));
+}
+
+static void on_source_destroy(void *, calldata_t *cd)
+{
+	obs_source_t *source = signal_source(cd);
+	if (!is_audio_input(source))
+		return;
+
+	const char *uuid = obs_source_get_uuid(source);
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	g_index.erase(std::remove_if(g_index.begin(), g_index.end(),
+				     [uuid](const audio_source_entry &entry) { return uuid && entry.uuid == uuid; }),
+		      g_index.end());
+}
+
+static void on_source_rename(void *, calldata_t *cd)
+{
+	obs_source_t *source = signal_source(cd);
+	const char *new_name = calldata_string(cd, "new_name");
+	if (!is_audio_input(source) || !new_name)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	if (audio_source_entry *entry = find_locked(obs_source_get_uuid(source)))
+		entry->name = new_name;
+}
+
+static void set_audio_active(calldata_t *cd, bool active)
+{
+	obs_source_t *source = signal_source(cd);
+	if (!is_audio_input(source))
+		return;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	if (audio_source_entry *entry = find_locked(obs_source_get_uuid(source)))
+		entry->audio_active = active;
+}
+
+static void on_source_audio_activate(void *, calldata_t *cd)
+{
+	set_audio_active(cd, true);
+}
+
+static void on_source_audio_deactivate(void *, calldata_t *cd)
+{
+	set_audio_active(cd, false);
+}
+
+struct index_signal {
+	const char *name;
+	signal_callback_t callback;
+};
+
+static const index_signal kIndexSignals[] = {
+	{"source_create", on_source_create},
+	{"source_destroy", on_source_destroy},
+	{"source_rename", on_source_rename},
+	{"source_audio_activate", on_source_audio_activate},
+	{"source_audio_deactivate", on_source_audio_deactivate},
+};
+
+static bool seed_source(void *, obs_source_t *source)
+{
+	add_source(source);
+	return true;
+}
+
+void audio_source_index_start()
+{
+	if (g_index_started)
+		return;
+
+	signal_handler_t *handler = obs_get_signal_handler();
+	if (!handler) {
+		BLOG(LOG_WARNING, "No OBS signal handler; audio source list will be empty");
+		return;
+	}
+
+	for (const index_signal &sig : kIndexSignals)
+		signal_handler_connect(handler, sig.name, sig.callback, nullptr);
+	g_index_started = true;
+
+	// Normally nothing exists yet at module load, but pick up anything that
+	// was created before the signals were connected.
+	obs_enum_sources(seed_source, nullptr);
+}
+
+void audio_source_index_stop()
+{
+	if (!g_index_started)
+		return;
+
+	signal_handler_t *handler = obs_get_signal_handler();
+	if (handler) {
+		for (const index_signal &sig : kIndexSignals)
+			signal_handler_disconnect(handler, sig.name, sig.callback, nullptr);
+	}
+	g_index_started = false;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	g_index.clear();
+}
+
+void audio_source_index_fill_list(obs_property_t *list)
+{
+	if (!list)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	for (const audio_source_entry &entry : g_index) {
+		if (entry.audio_active)
+			obs_property_list_add_string(list, entry.name.c_str(), entry.uuid.c_str());
+	}
+}
+
+bool audio_source_index_find_uuid(const char *name, std::string &uuid)
+{
+	if (!name || !*name)
+		return false;
+
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	for (const audio_source_entry &entry : g_index) {
+		if (entry.name == name) {
+			uuid = entry.uuid;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool audio_source_index_find_name(const char *uuid, std::string &name)
+{
+	std::lock_guard<std::mutex> lock(g_index_mutex);
+	const audio_source_entry *entry = find_locked(uuid);
+	if (!entry)
+		return false;
+	name = entry->name;
+	return true;
+}
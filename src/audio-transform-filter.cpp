@@ -0,0 +1,289 @@
+#include "includes/audio-transform-filter.hpp"
+#include "includes/pipeline-trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *kFilterId = "audio_shader_engine_transform_filter";
+static const char *kFilterName = "Audio Reactive Transform";
+
+static const char *S_DRIVER = "transform_driver";
+static const char *S_SCALE_AMOUNT = "transform_scale";
+static const char *S_OPACITY_AMOUNT = "transform_opacity";
+static const char *S_ROTATION_DEG = "transform_rotation";
+static const char *S_OFFSET_X = "transform_offset_x";
+static const char *S_OFFSET_Y = "transform_offset_y";
+
+static obs_source_info g_filter_info = {};
+
+// The parent texture is premultiplied, so fading it means scaling all four
+// channels. The default effect's multiplier only scales rgb, which darkens
+// the source instead of making it transparent.
+static const char *kOpacityEffect = R"(
+uniform float4x4 ViewProj;
+uniform texture2d image;
+uniform float opacity = 1.0;
+
+sampler_state def_sampler {
+	Filter = Linear;
+	AddressU = Clamp;
+	AddressV = Clamp;
+};
+
+struct VertInOut {
+	float4 pos : POSITION;
+	float2 uv : TEXCOORD0;
+};
+
+VertInOut VSDefault(VertInOut vert_in)
+{
+	VertInOut vert_out;
+	vert_out.pos = mul(float4(vert_in.pos.xyz, 1.0), ViewProj);
+	vert_out.uv = vert_in.uv;
+	return vert_out;
+}
+
+float4 PSOpacity(VertInOut vert_in) : TARGET
+{
+	return image.Sample(def_sampler, vert_in.uv) * opacity;
+}
+
+technique Draw
+{
+	pass
+	{
+		vertex_shader = VSDefault(vert_in);
+		pixel_shader = PSOpacity(vert_in);
+	}
+}
+)";
+
+static float driver_value(const audio_analyzer &a, int driver)
+{
+	switch (driver) {
+	case AUDIO_DRIVER_PEAK:
+		return a.peak;
+	case AUDIO_DRIVER_BASS:
+		return a.bass;
+	case AUDIO_DRIVER_MID:
+		return a.mid;
+	case AUDIO_DRIVER_TREBLE:
+		return a.treble;
+	case AUDIO_DRIVER_SECTION:
+		return a.section_change;
+	default:
+		return a.level;
+	}
+}
+
+static const char *filter_name(void *)
+{
+	return kFilterName;
+}
+
+static obs_properties_t *filter_properties(void *data)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	obs_properties_t *props = obs_properties_create();
+
+	audio_analyzer_add_source_list(props);
+
+	obs_property_t *driver = obs_properties_add_list(props, S_DRIVER, "Driven By", OBS_COMBO_TYPE_LIST,
+							 OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(driver, "Level", AUDIO_DRIVER_LEVEL);
+	obs_property_list_add_int(driver, "Peak", AUDIO_DRIVER_PEAK);
+	obs_property_list_add_int(driver, "Bass", AUDIO_DRIVER_BASS);
+	obs_property_list_add_int(driver, "Mid", AUDIO_DRIVER_MID);
+	obs_property_list_add_int(driver, "Treble", AUDIO_DRIVER_TREBLE);
+	obs_property_list_add_int(driver, "Section Change", AUDIO_DRIVER_SECTION);
+
+	obs_properties_add_float_slider(props, S_SCALE_AMOUNT, "Scale Boost", -1.0, 2.0, 0.01);
+	obs_properties_add_float_slider(props, S_OPACITY_AMOUNT, "Opacity Dip When Quiet", 0.0, 1.0, 0.01);
+	obs_properties_add_float_slider(props, S_ROTATION_DEG, "Rotation at Full Drive", -180.0, 180.0, 0.5);
+	obs_properties_add_float_slider(props, S_OFFSET_X, "Offset X at Full Drive", -1000.0, 1000.0, 1.0);
+	obs_properties_add_float_slider(props, S_OFFSET_Y, "Offset Y at Full Drive", -1000.0, 1000.0, 1.0);
+
+	audio_analyzer_add_properties(props, f ? &f->analyzer : nullptr);
+
+	return props;
+}
+
+static void filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, S_DRIVER, AUDIO_DRIVER_BASS);
+	obs_data_set_default_double(settings, S_SCALE_AMOUNT, 0.15);
+	obs_data_set_default_double(settings, S_OPACITY_AMOUNT, 0.0);
+	obs_data_set_default_double(settings, S_ROTATION_DEG, 0.0);
+	obs_data_set_default_double(settings, S_OFFSET_X, 0.0);
+	obs_data_set_default_double(settings, S_OFFSET_Y, 0.0);
+	audio_analyzer_defaults(settings);
+}
+
+static void filter_update(void *data, obs_data_t *settings)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (!f)
+		return;
+
+	audio_analyzer_detach(&f->analyzer);
+
+	std::lock_guard<std::mutex> lock(f->mutex);
+
+	audio_analyzer_update_settings(&f->analyzer, settings);
+	f->driver = std::clamp<int>((int)obs_data_get_int(settings, S_DRIVER), AUDIO_DRIVER_LEVEL,
+				    AUDIO_DRIVER_SECTION);
+	f->scale_amount = float(obs_data_get_double(settings, S_SCALE_AMOUNT));
+	f->opacity_amount = float(obs_data_get_double(settings, S_OPACITY_AMOUNT));
+	f->rotation_deg = float(obs_data_get_double(settings, S_ROTATION_DEG));
+	f->offset_x = float(obs_data_get_double(settings, S_OFFSET_X));
+	f->offset_y = float(obs_data_get_double(settings, S_OFFSET_Y));
+
+	// Audio is bound on first show, not while a scene collection loads.
+	if (obs_source_showing(f->self))
+		audio_analyzer_attach(&f->analyzer);
+}
+
+static void *filter_create(obs_data_t *settings, obs_source_t *source)
+{
+	auto *f = new (std::nothrow) audio_transform_filter{};
+	if (!f)
+		return nullptr;
+
+	f->self = source;
+	audio_analyzer_init(&f->analyzer, source);
+	filter_update(f, settings);
+	return f;
+}
+
+static void filter_destroy(void *data)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (!f)
+		return;
+
+	audio_analyzer_shutdown(&f->analyzer);
+
+	if (f->opacity_effect) {
+		obs_enter_graphics();
+		gs_effect_destroy(f->opacity_effect);
+		obs_leave_graphics();
+	}
+
+	delete f;
+}
+
+static void filter_video_tick(void *data, float)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (!f)
+		return;
+
+	// Hidden filters skip analysis, like hidden sources.
+	std::lock_guard<std::mutex> lock(f->mutex);
+	if (obs_source_showing(f->self))
+		audio_analyzer_tick_async(&f->analyzer, os_gettime_ns());
+}
+
+static void filter_render(void *data, gs_effect_t *)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (!f)
+		return;
+
+	AW_TRACE_SCOPE("filter_render");
+
+	obs_source_t *target = obs_filter_get_target(f->self);
+	const uint32_t width = target ? obs_source_get_base_width(target) : 0;
+	const uint32_t height = target ? obs_source_get_base_height(target) : 0;
+	if (!width || !height) {
+		obs_source_skip_video_filter(f->self);
+		return;
+	}
+
+	float scale = 1.0f;
+	float opacity = 1.0f;
+	float rotation = 0.0f;
+	float offset_x = 0.0f;
+	float offset_y = 0.0f;
+	{
+		std::lock_guard<std::mutex> lock(f->mutex);
+		if (audio_analyzer_wait(&f->analyzer))
+			f->drive = clamp01(driver_value(f->analyzer, f->driver));
+		const float d = f->drive;
+		scale = std::max(0.0f, 1.0f + f->scale_amount * d);
+		opacity = clamp01(1.0f - f->opacity_amount * (1.0f - d));
+		rotation = f->rotation_deg * d * (3.14159265358979323846f / 180.0f);
+		offset_x = f->offset_x * d;
+		offset_y = f->offset_y * d;
+	}
+
+	// Built on first render, where the graphics context is current. If it
+	// fails to compile, the source is still transformed at full opacity.
+	if (!f->opacity_effect && !f->opacity_effect_failed) {
+		char *compile_error = nullptr;
+		f->opacity_effect = gs_effect_create(kOpacityEffect, nullptr, &compile_error);
+		if (!f->opacity_effect) {
+			f->opacity_effect_failed = true;
+			BLOG(LOG_ERROR, "Filter '%s' could not build its opacity effect: %s", obs_source_get_name(f->self),
+			     compile_error ? compile_error : "unknown error");
+		}
+		if (compile_error)
+			bfree(compile_error);
+	}
+
+	if (!obs_source_process_filter_begin(f->self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING))
+		return;
+
+	gs_effect_t *effect = f->opacity_effect ? f->opacity_effect : obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	if (f->opacity_effect)
+		gs_effect_set_float(gs_effect_get_param_by_name(effect, "opacity"), opacity);
+
+	const float cx = float(width) * 0.5f;
+	const float cy = float(height) * 0.5f;
+
+	gs_matrix_push();
+	gs_matrix_translate3f(cx + offset_x, cy + offset_y, 0.0f);
+	gs_matrix_rotaa4f(0.0f, 0.0f, 1.0f, rotation);
+	gs_matrix_scale3f(scale, scale, 1.0f);
+	gs_matrix_translate3f(-cx, -cy, 0.0f);
+	obs_source_process_filter_tech_end(f->self, effect, width, height, "Draw");
+	gs_matrix_pop();
+}
+
+static void filter_show(void *data)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (f)
+		audio_analyzer_attach(&f->analyzer);
+}
+
+static void filter_hide(void *data)
+{
+	auto *f = static_cast<audio_transform_filter *>(data);
+	if (f)
+		audio_analyzer_detach(&f->analyzer);
+}
+
+extern "C" void register_audio_transform_filter(void)
+{
+	std::memset(&g_filter_info, 0, sizeof(g_filter_info));
+	g_filter_info.id = kFilterId;
+	g_filter_info.type = OBS_SOURCE_TYPE_FILTER;
+	g_filter_info.output_flags = OBS_SOURCE_VIDEO;
+	g_filter_info.get_name = filter_name;
+	g_filter_info.create = filter_create;
+	g_filter_info.destroy = filter_destroy;
+	g_filter_info.update = filter_update;
+	g_filter_info.get_defaults = filter_defaults;
+	g_filter_info.get_properties = filter_properties;
+	g_filter_info.video_render = filter_render;
+	g_filter_info.video_tick = filter_video_tick;
+	g_filter_info.show = filter_show;
+	g_filter_info.hide = filter_hide;
+	obs_register_source(&g_filter_info);
+	BLOG(LOG_INFO, "Registered filter '%s'", kFilterId);
+}
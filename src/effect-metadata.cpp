@@ -0,0 +1,148 @@
+#include "includes/effect-metadata.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+
+static std::string trim_copy(const std::string &v)
+{
+	size_t a = 0;
+	while (a < v.size() && std::isspace((unsigned char)v[a]))
+		++a;
+	size_t b = v.size();
+	while (b > a && std::isspace((unsigned char)v[b - 1]))
+		--b;
+	return v.substr(a, b - a);
+}
+
+// Strict "<prefix><digits>" key index; rejects signs, spaces, trailing text
+// and anything outside 1..max_index, unlike atoi.
+static int parse_key_index(const std::string &key, const char *prefix, int max_index)
+{
+	const size_t prefix_len = std::strlen(prefix);
+	if (key.size() <= prefix_len || key.size() > prefix_len + 2 || key.compare(0, prefix_len, prefix) != 0)
+		return 0;
+
+	int idx = 0;
+	const char *first = key.data() + prefix_len;
+	const char *last = key.data() + key.size();
+	const auto result = std::from_chars(first, last, idx);
+	if (result.ec != std::errc() || result.ptr != last)
+		return 0;
+	return idx >= 1 && idx <= max_index ? idx : 0;
+}
+
+static std::string clamp_label(const std::string &value)
+{
+	return value.size() > kMaxMetadataLabelLength ? value.substr(0, kMaxMetadataLabelLength) : value;
+}
+
+// Reads one line into line, taking bytes out of budget. Characters past
+// kMaxMetadataLineBytes are consumed but dropped and flag the line as
+// too_long. Returns false at end of input or once the budget is spent before
+// the line ends; that partial line is not returned.
+static bool read_bounded_line(std::istream &in, std::string &line, size_t &budget, bool &too_long)
+{
+	line.clear();
+	too_long = false;
+	std::streambuf *buf = in.rdbuf();
+	if (!buf)
+		return false;
+
+	bool any = false;
+	while (budget > 0) {
+		const int c = buf->sbumpc();
+		if (c == std::char_traits<char>::eof())
+			return any;
+		--budget;
+		any = true;
+		if (c == '\n')
+			return true;
+		if (line.size() < kMaxMetadataLineBytes)
+			line.push_back(char(c));
+		else
+			too_long = true;
+	}
+	return false;
+}
+
+effect_metadata parse_effect_metadata(std::istream &file)
+{
+	effect_metadata meta;
+
+	std::string section;
+	std::string line;
+	size_t budget = kMaxMetadataBytes;
+	bool too_long = false;
+	bool first_line = true;
+	while (read_bounded_line(file, line, budget, too_long)) {
+		if (first_line) {
+			if (line.compare(0, 3, "\xEF\xBB\xBF") == 0)
+				line.erase(0, 3);
+			first_line = false;
+		}
+		// A cut-off line could parse as a different key or section.
+		if (too_long)
+			continue;
+
+		line = trim_copy(line);
+		if (line.empty() || line[0] == '#' || line[0] == ';')
+			continue;
+		if (line.front() == '[' && line.back() == ']' && line.size() >= 2) {
+			section = trim_copy(line.substr(1, line.size() - 2));
+			std::transform(section.begin(), section.end(), section.begin(),
+				       [](unsigned char c) { return (char)std::tolower(c); });
+			continue;
+		}
+
+		const size_t eq = line.find('=');
+		if (eq == std::string::npos)
+			continue;
+
+		std::string key = trim_copy(line.substr(0, eq));
+		std::string value = trim_copy(line.substr(eq + 1));
+		if (value.empty())
+			continue;
+
+		if (section == "effect" && key == "name") {
+			meta.name = clamp_label(value);
+		} else if (section == "options") {
+			const int idx = parse_key_index(key, "option", 8);
+			if (idx > 0 && value.rfind("Custom Option", 0) != 0)
+				meta.option_labels[(size_t)idx - 1] = clamp_label(value);
+		} else if (section == "colors") {
+			const int idx = parse_key_index(key, "color", 4);
+			if (idx > 0)
+				meta.color_labels[(size_t)idx - 1] = clamp_label(value);
+		} else if (section == "quality") {
+			if (key == "tiers") {
+				int tiers = 1;
+				std::from_chars(value.data(), value.data() + value.size(), tiers);
+				meta.quality_tiers = std::clamp(tiers, 1, kMaxQualityTiers);
+			} else if (key == "mode") {
+				meta.quality_uniform = value == "uniform";
+			} else {
+				const int idx = parse_key_index(key, "tier", kMaxQualityTiers);
+				if (idx > 0)
+					meta.tier_labels[(size_t)idx - 1] = clamp_label(value);
+			}
+		}
+	}
+
+	return meta;
+}
+
+effect_metadata load_effect_metadata(const std::string &effect_path)
+{
+	if (effect_path.empty())
+		return {};
+
+	const std::string ini_path = effect_path + ".ini";
+	std::ifstream file(ini_path, std::ios::binary);
+	if (!file.is_open())
+		return {};
+
+	return parse_effect_metadata(file);
+}
@@ -0,0 +1,470 @@
+#include "includes/effect-registry.hpp"
+#include "includes/pipeline-trace.hpp"
+#include "includes/probes.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+// Array uniforms the plugin fills, with the length assumed when the
+// declaration cannot be read from the effect source.
+static const char *kBandsUniform = "audio_bands";
+static const char *kBands4Uniform = "audio_bands4";
+static const char *kFeaturesUniform = "audio_features";
+static constexpr size_t kBandsDefaultLen = 64;
+static constexpr size_t kBands4DefaultLen = 16;
+static constexpr size_t kFeaturesDefaultLen = 2;
+
+// Pause after each preload compile. Every compile holds the graphics
+// context, so back-to-back preloads at startup would stall several frames.
+static constexpr std::chrono::milliseconds kPreloadGap{100};
+
+static std::mutex g_registry_mutex;
+static std::vector<std::unique_ptr<effect_entry>> g_entries;
+
+// Background compiles, guarded by g_registry_mutex. Each request is the
+// canonical path and variant; preloads only run while g_compile_queue is
+// empty.
+static std::condition_variable g_compile_cv;
+static std::deque<std::pair<std::string, std::string>> g_compile_queue;
+static std::deque<std::pair<std::string, std::string>> g_preload_queue;
+static std::thread g_compile_thread;
+static bool g_compile_stop = false;
+
+static std::string canonical_path(const std::string &path)
+{
+	char *abs = os_get_abs_path_ptr(path.c_str());
+	if (!abs)
+		return path;
+	std::string result = abs;
+	bfree(abs);
+	return result;
+}
+
+static bool is_ident_char(char c)
+{
+	return std::isalnum((unsigned char)c) || c == '_';
+}
+
+// Finds "uniform <type> <name>[N]" in an effect source and returns N, or 0
+// when there is no such declaration.
+static size_t declared_array_length(const std::string &src, const char *type, const char *name)
+{
+	const size_t name_len = strlen(name);
+	for (size_t at = src.find(name); at != std::string::npos; at = src.find(name, at + name_len)) {
+		if ((at > 0 && is_ident_char(src[at - 1])) ||
+		    (at + name_len < src.size() && is_ident_char(src[at + name_len])))
+			continue;
+
+		size_t p = at + name_len;
+		while (p < src.size() && std::isspace((unsigned char)src[p]))
+			++p;
+		if (p >= src.size() || src[p] != '[')
+			continue;
+		size_t len = 0;
+		const char *first = src.data() + p + 1;
+		const char *last = src.data() + src.size();
+		while (first < last && std::isspace((unsigned char)*first))
+			++first;
+		auto res = std::from_chars(first, last, len);
+		while (res.ec == std::errc() && res.ptr < last && std::isspace((unsigned char)*res.ptr))
+			++res.ptr;
+		if (res.ec != std::errc() || res.ptr >= last || *res.ptr != ']')
+			continue;
+
+		// Walk back over the type and the uniform keyword.
+		size_t q = at;
+		while (q > 0 && std::isspace((unsigned char)src[q - 1]))
+			--q;
+		size_t type_start = q;
+		while (type_start > 0 && is_ident_char(src[type_start - 1]))
+			--type_start;
+		if (src.compare(type_start, q - type_start, type) != 0)
+			continue;
+		size_t k = type_start;
+		while (k > 0 && std::isspace((unsigned char)src[k - 1]))
+			--k;
+		if (k >= 7 && src.compare(k - 7, 7, "uniform") == 0)
+			return len;
+	}
+	return 0;
+}
+
+static void resolve_params(effect_entry *entry, const std::string &src)
+{
+	gs_effect_t *e = entry->effect;
+	effect_params &p = entry->params;
+
+	p.source_size = gs_effect_get_param_by_name(e, "source_size");
+	p.resolution = gs_effect_get_param_by_name(e, "resolution");
+	p.time = gs_effect_get_param_by_name(e, "time");
+	p.audio_level = gs_effect_get_param_by_name(e, "audio_level");
+	p.audio_peak = gs_effect_get_param_by_name(e, "audio_peak");
+	p.audio_bass = gs_effect_get_param_by_name(e, "audio_bass");
+	p.audio_mid = gs_effect_get_param_by_name(e, "audio_mid");
+	p.audio_treble = gs_effect_get_param_by_name(e, "audio_treble");
+	p.audio_section_change = gs_effect_get_param_by_name(e, "audio_section_change");
+	p.audio_energy_trend = gs_effect_get_param_by_name(e, "audio_energy_trend");
+	p.band_count = gs_effect_get_param_by_name(e, "band_count");
+	p.band_texture = gs_effect_get_param_by_name(e, "audio_band_texture");
+	p.spectrum_texture = gs_effect_get_param_by_name(e, "audio_spectrum_texture");
+	p.quality = gs_effect_get_param_by_name(e, "quality");
+	for (size_t i = 0; i < p.options.size(); ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "option%zu", i + 1);
+		p.options[i] = gs_effect_get_param_by_name(e, name);
+	}
+	for (size_t i = 0; i < p.colors.size(); ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "color%zu", i + 1);
+		p.colors[i] = gs_effect_get_param_by_name(e, name);
+	}
+
+	p.bands = gs_effect_get_param_by_name(e, kBandsUniform);
+	p.bands4 = gs_effect_get_param_by_name(e, kBands4Uniform);
+	p.features = gs_effect_get_param_by_name(e, kFeaturesUniform);
+	auto length_of = [&src](gs_eparam_t *param, const char *type, const char *name, size_t fallback) {
+		if (!param)
+			return size_t(0);
+		const size_t declared = declared_array_length(src, type, name);
+		return std::min<size_t>(declared ? declared : fallback, 256);
+	};
+	p.bands_len = length_of(p.bands, "float", kBandsUniform, kBandsDefaultLen);
+	p.bands4_len = length_of(p.bands4, "float4", kBands4Uniform, kBands4DefaultLen);
+	p.features_len = length_of(p.features, "float4", kFeaturesUniform, kFeaturesDefaultLen);
+
+	entry->samples_image = gs_effect_get_param_by_name(e, "image") != nullptr;
+}
+
+// Needs no graphics context, so background compiles read the file before
+// entering it.
+static bool read_effect_source(const std::string &path, std::string &src, std::string &error)
+{
+	char *text = os_quick_read_utf8_file(path.c_str());
+	if (!text) {
+		error = "Could not read effect file";
+		return false;
+	}
+	src = text;
+	bfree(text);
+	return true;
+}
+
+// libobs keeps every effect created with a file name in a global cache for
+// the lifetime of the graphics subsystem and shares it between callers, so
+// gs_effect_destroy() never frees it and a reload returns the stale copy.
+// Effects are therefore compiled from their text without a file name. Only
+// effects that #include other files need the name to resolve the include;
+// those fall back to the cached libobs path and cannot take a variant.
+static gs_effect_t *build_effect(const std::string &path, const std::string &variant, const std::string &src,
+				 std::string &error)
+{
+	char *compile_error = nullptr;
+	gs_effect_t *effect = nullptr;
+	if (src.find("#include") != std::string::npos) {
+		if (!variant.empty())
+			BLOG(LOG_WARNING, "Effect '%s' uses #include; quality variants are ignored", path.c_str());
+		effect = gs_effect_create_from_file(path.c_str(), &compile_error);
+	} else {
+		const std::string full = variant + src;
+		effect = gs_effect_create(full.c_str(), nullptr, &compile_error);
+	}
+
+	if (!effect)
+		error = compile_error ? compile_error : "Unknown shader compile error";
+	if (compile_error)
+		bfree(compile_error);
+	return effect;
+}
+
+static std::string entry_key(const std::string &canonical, const std::string &variant)
+{
+	return canonical + '\n' + variant;
+}
+
+// Must be called with g_registry_mutex held.
+static effect_entry *find_locked(const std::string &key)
+{
+	for (const std::unique_ptr<effect_entry> &entry : g_entries) {
+		if (!entry->superseded && entry->key == key)
+			return entry.get();
+	}
+	return nullptr;
+}
+
+// Takes a reference for the caller; a pinned entry hands the registry's
+// reference over instead. Must be called with g_registry_mutex held.
+static effect_entry *claim_locked(effect_entry *entry)
+{
+	if (entry->pinned)
+		entry->pinned = false;
+	else
+		++entry->refs;
+	return entry;
+}
+
+static std::unique_ptr<effect_entry> make_entry(const std::string &key, const std::string &canonical,
+						const std::string &variant, gs_effect_t *effect, const std::string &src)
+{
+	auto entry = std::make_unique<effect_entry>();
+	entry->key = key;
+	entry->path = canonical;
+	entry->variant = variant;
+	entry->effect = effect;
+	entry->refs = 1;
+	resolve_params(entry.get(), src);
+	return entry;
+}
+
+effect_entry *effect_registry_acquire(const std::string &path, const std::string &variant, std::string &error)
+{
+	const std::string canonical = canonical_path(path);
+	const std::string key = entry_key(canonical, variant);
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	if (effect_entry *entry = find_locked(key))
+		return claim_locked(entry);
+
+	AW_TRACE_SCOPE("effect_compile");
+	const uint64_t probe_t0 = AW_PROBE_CLOCK(effect_load_exit);
+	AW_PROBE1(effect_load_entry, path.c_str());
+
+	BLOG(LOG_INFO, "Loading effect: %s", path.c_str());
+	std::string src;
+	gs_effect_t *effect = read_effect_source(canonical, src, error) ? build_effect(canonical, variant, src, error)
+									: nullptr;
+	AW_PROBE3(effect_load_exit, path.c_str(), effect != nullptr, aw_probe_elapsed(probe_t0));
+	if (!effect) {
+		BLOG(LOG_ERROR, "Could not load effect '%s': %s", path.c_str(), error.c_str());
+		return nullptr;
+	}
+
+	g_entries.push_back(make_entry(key, canonical, variant, effect, src));
+
+	BLOG(LOG_INFO, "Effect loaded successfully: %s (%zu compiled effects cached)", path.c_str(), g_entries.size());
+	return g_entries.back().get();
+}
+
+void effect_registry_release(effect_entry *entry)
+{
+	if (!entry)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	if (--entry->refs > 0)
+		return;
+
+	gs_effect_destroy(entry->effect);
+	g_entries.erase(std::remove_if(g_entries.begin(), g_entries.end(),
+				       [entry](const std::unique_ptr<effect_entry> &e) { return e.get() == entry; }),
+			g_entries.end());
+}
+
+void effect_registry_invalidate(const std::string &path)
+{
+	const std::string canonical = canonical_path(path);
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	for (auto it = g_entries.begin(); it != g_entries.end();) {
+		effect_entry *entry = it->get();
+		if (entry->path != canonical) {
+			++it;
+			continue;
+		}
+		entry->superseded = true;
+		// Nobody will claim a superseded entry, so the registry's own
+		// reference to a background compile goes now.
+		if ((entry->pinned || entry->resident) && --entry->refs <= 0) {
+			gs_effect_destroy(entry->effect);
+			it = g_entries.erase(it);
+			continue;
+		}
+		entry->pinned = false;
+		entry->resident = false;
+		++it;
+	}
+}
+
+effect_entry *effect_registry_try_acquire(const std::string &path, const std::string &variant)
+{
+	const std::string key = entry_key(canonical_path(path), variant);
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	effect_entry *entry = find_locked(key);
+	return entry ? claim_locked(entry) : nullptr;
+}
+
+// Keeps an effect someone already loaded compiled after they release it.
+// Must be called with g_registry_mutex held.
+static void make_resident_locked(effect_entry *entry)
+{
+	if (entry->resident)
+		return;
+	entry->resident = true;
+	if (entry->pinned)
+		entry->pinned = false;
+	else
+		++entry->refs;
+}
+
+static void compile_worker()
+{
+	os_set_thread_name("aw-effect-compile");
+
+	std::unique_lock<std::mutex> lock(g_registry_mutex);
+	for (;;) {
+		g_compile_cv.wait(lock,
+				  [] { return g_compile_stop || !g_compile_queue.empty() || !g_preload_queue.empty(); });
+		if (g_compile_stop)
+			return;
+
+		const bool preload = g_compile_queue.empty();
+		auto &queue = preload ? g_preload_queue : g_compile_queue;
+		const auto [canonical, variant] = queue.front();
+		queue.pop_front();
+		const std::string key = entry_key(canonical, variant);
+		if (effect_entry *existing = find_locked(key)) {
+			if (preload)
+				make_resident_locked(existing);
+			continue;
+		}
+		lock.unlock();
+
+		// Reading the file needs no graphics context. The compile itself
+		// does, which also keeps the render thread out for its duration,
+		// but it no longer runs inside a source's render call.
+		std::string src;
+		std::string error;
+		gs_effect_t *effect = nullptr;
+		if (read_effect_source(canonical, src, error)) {
+			obs_enter_graphics();
+			if (gs_get_context())
+				effect = build_effect(canonical, variant, src, error);
+			else
+				error = "Graphics are not initialized";
+			obs_leave_graphics();
+		}
+
+		lock.lock();
+		if (!effect) {
+			BLOG(LOG_WARNING, "Background compile of '%s' failed: %s", canonical.c_str(), error.c_str());
+			continue;
+		}
+		if (effect_entry *existing = find_locked(key)) {
+			// Compiled synchronously in the meantime; keep that copy.
+			if (preload)
+				make_resident_locked(existing);
+			lock.unlock();
+			obs_enter_graphics();
+			gs_effect_destroy(effect);
+			obs_leave_graphics();
+			lock.lock();
+			continue;
+		}
+
+		std::unique_ptr<effect_entry> entry = make_entry(key, canonical, variant, effect, src);
+		if (preload)
+			entry->resident = true;
+		else
+			entry->pinned = true;
+		g_entries.push_back(std::move(entry));
+		BLOG(LOG_INFO, "Effect %s in background: %s", preload ? "preloaded" : "compiled", canonical.c_str());
+
+		if (preload)
+			g_compile_cv.wait_for(lock, kPreloadGap, [] { return g_compile_stop || !g_compile_queue.empty(); });
+	}
+}
+
+static bool is_queued(const std::deque<std::pair<std::string, std::string>> &queue, const std::string &canonical,
+		      const std::string &variant)
+{
+	for (const auto &request : queue) {
+		if (request.first == canonical && request.second == variant)
+			return true;
+	}
+	return false;
+}
+
+// Must be called with g_registry_mutex held.
+static void wake_worker_locked()
+{
+	if (!g_compile_thread.joinable()) {
+		g_compile_stop = false;
+		g_compile_thread = std::thread(compile_worker);
+	}
+	g_compile_cv.notify_one();
+}
+
+void effect_registry_compile_async(const std::string &path, const std::string &variant)
+{
+	const std::string canonical = canonical_path(path);
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	if (find_locked(entry_key(canonical, variant)) || is_queued(g_compile_queue, canonical, variant))
+		return;
+
+	g_compile_queue.emplace_back(canonical, variant);
+	wake_worker_locked();
+}
+
+void effect_registry_preload(const std::string &path, const std::string &variant)
+{
+	const std::string canonical = canonical_path(path);
+
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	if (is_queued(g_preload_queue, canonical, variant))
+		return;
+	if (effect_entry *existing = find_locked(entry_key(canonical, variant))) {
+		make_resident_locked(existing);
+		return;
+	}
+
+	g_preload_queue.emplace_back(canonical, variant);
+	wake_worker_locked();
+}
+
+void effect_registry_stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(g_registry_mutex);
+		g_compile_stop = true;
+		g_compile_queue.clear();
+		g_preload_queue.clear();
+	}
+	g_compile_cv.notify_all();
+	if (g_compile_thread.joinable())
+		g_compile_thread.join();
+
+	// Sources have released their effects by now; only background compiles
+	// held by the registry itself are left. Skip the destroy if graphics is
+	// already gone.
+	obs_enter_graphics();
+	std::lock_guard<std::mutex> lock(g_registry_mutex);
+	for (auto it = g_entries.begin(); it != g_entries.end();) {
+		effect_entry *entry = it->get();
+		if ((entry->pinned || entry->resident) && --entry->refs <= 0) {
+			if (gs_get_context())
+				gs_effect_destroy(entry->effect);
+			it = g_entries.erase(it);
+			continue;
+		}
+		entry->pinned = false;
+		entry->resident = false;
+		++it;
+	}
+	obs_leave_graphics();
+}
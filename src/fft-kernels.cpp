@@ -0,0 +1,176 @@
+#include "includes/fft-kernels.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+static constexpr double kPi = 3.14159265358979323846;
+
+// std::sin/std::cos are not constexpr before C++26. Twiddle angles lie in
+// [-pi, 0], where a 30-term Taylor series is accurate to double precision.
+static constexpr double constexpr_sin(double x)
+{
+	double term = x;
+	double sum = x;
+	for (int i = 1; i < 30; ++i) {
+		term *= -x * x / double((2 * i) * (2 * i + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+static constexpr double constexpr_cos(double x)
+{
+	double term = 1.0;
+	double sum = 1.0;
+	for (int i = 1; i < 30; ++i) {
+		term *= -x * x / double((2 * i - 1) * (2 * i));
+		sum += term;
+	}
+	return sum;
+}
+
+template<size_t N> struct fft_tables {
+	static_assert(N >= 4 && (N & (N - 1)) == 0, "FFT size must be a power of two >= 4");
+
+	std::array<uint16_t, N> bitrev{};
+	std::array<float, N / 2> tw_re{};
+	std::array<float, N / 2> tw_im{};
+};
+
+template<size_t N> static constexpr fft_tables<N> make_fft_tables()
+{
+	fft_tables<N> t{};
+
+	size_t bits = 0;
+	while ((size_t(1) << bits) < N)
+		++bits;
+	for (size_t i = 0; i < N; ++i) {
+		size_t r = 0;
+		for (size_t b = 0; b < bits; ++b)
+			r |= ((i >> b) & 1u) << (bits - 1 - b);
+		t.bitrev[i] = uint16_t(r);
+	}
+
+	for (size_t k = 0; k < N / 2; ++k) {
+		const double ang = -2.0 * kPi * double(k) / double(N);
+		t.tw_re[k] = float(constexpr_cos(ang));
+		t.tw_im[k] = float(constexpr_sin(ang));
+	}
+	return t;
+}
+
+template<size_t N> static constexpr fft_tables<N> kFftTables = make_fft_tables<N>();
+
+template<size_t N> static void fft_kernel(std::complex<float> *a)
+{
+	const fft_tables<N> &t = kFftTables<N>;
+
+	for (size_t i = 0; i < N; ++i) {
+		const size_t j = t.bitrev[i];
+		if (i < j)
+			std::swap(a[i], a[j]);
+	}
+
+	// Stages of length 2 and 4: twiddles are 1 and -i, so no multiplies.
+	for (size_t i = 0; i < N; i += 4) {
+		const std::complex<float> b0 = a[i] + a[i + 1];
+		const std::complex<float> b1 = a[i] - a[i + 1];
+		const std::complex<float> b2 = a[i + 2] + a[i + 3];
+		const std::complex<float> b3 = a[i + 2] - a[i + 3];
+		const std::complex<float> b3_rot(b3.imag(), -b3.real());
+		a[i] = b0 + b2;
+		a[i + 2] = b0 - b2;
+		a[i + 1] = b1 + b3_rot;
+		a[i + 3] = b1 - b3_rot;
+	}
+
+	// Remaining stages. The complex multiply is spelled out so it does not go
+	// through the NaN-checking std::complex operator*.
+	float *d = reinterpret_cast<float *>(a);
+	for (size_t len = 8; len <= N; len <<= 1) {
+		const size_t half = len / 2;
+		const size_t step = N / len;
+		for (size_t i = 0; i < N; i += len) {
+			for (size_t j = 0; j < half; ++j) {
+				const float wr = t.tw_re[j * step];
+				const float wi = t.tw_im[j * step];
+				float *u = d + 2 * (i + j);
+				float *v = d + 2 * (i + j + half);
+				const float vr = v[0] * wr - v[1] * wi;
+				const float vi = v[0] * wi + v[1] * wr;
+				v[0] = u[0] - vr;
+				v[1] = u[1] - vi;
+				u[0] += vr;
+				u[1] += vi;
+			}
+		}
+	}
+}
+
+struct fft_kernel_entry {
+	size_t n;
+	fft_kernel_fn fn;
+};
+
+static const fft_kernel_entry kFftKernels[] = {
+	{256, fft_kernel<256>},   {512, fft_kernel<512>},   {1024, fft_kernel<1024>},
+	{2048, fft_kernel<2048>}, {4096, fft_kernel<4096>}, {8192, fft_kernel<8192>},
+};
+
+fft_kernel_fn fft_kernel_for_size(size_t n)
+{
+	for (const fft_kernel_entry &entry : kFftKernels) {
+		if (entry.n == n)
+			return entry.fn;
+	}
+	return nullptr;
+}
+
+static bool is_pow2(size_t n)
+{
+	return n >= 2 && (n & (n - 1)) == 0;
+}
+
+// Accumulating the twiddle with repeated complex multiplies drifts noticeably
+// by the last stages of an 8192-point transform, so every entry is computed
+// directly in double precision.
+void fft_build_twiddles(std::vector<std::complex<float>> &twiddles, size_t n)
+{
+	twiddles.resize(n / 2);
+	for (size_t k = 0; k < n / 2; ++k) {
+		const double ang = -2.0 * kPi * double(k) / double(n);
+		twiddles[k] = std::complex<float>(float(std::cos(ang)), float(std::sin(ang)));
+	}
+}
+
+bool fft_inplace(std::vector<std::complex<float>> &a, const std::vector<std::complex<float>> &twiddles)
+{
+	const size_t n = a.size();
+	if (!is_pow2(n) || twiddles.size() != n / 2)
+		return false;
+
+	for (size_t i = 1, j = 0; i < n; ++i) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(a[i], a[j]);
+	}
+
+	for (size_t len = 2; len <= n; len <<= 1) {
+		const size_t half = len / 2;
+		const size_t step = n / len;
+		for (size_t i = 0; i < n; i += len) {
+			for (size_t j = 0; j < half; ++j) {
+				const std::complex<float> u = a[i + j];
+				const std::complex<float> v = a[i + j + half] * twiddles[j * step];
+				a[i + j] = u + v;
+				a[i + j + half] = u - v;
+			}
+		}
+	}
+	return true;
+}
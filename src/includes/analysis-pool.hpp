@@ -0,0 +1,47 @@
+#pragma once
+
+#include "thread-priority.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+// Small work-stealing pool that runs analyzer jobs off the graphics thread.
+// Each worker owns a deque: submissions are spread round-robin, a worker pops
+// its own newest job first and steals the oldest job from the others when it
+// runs dry. Jobs are owned by the caller and reused every frame; a job that
+// no worker has picked up yet is run inline by whoever waits on it, so a busy
+// pool never delays a frame longer than running the job directly would.
+
+enum analysis_job_state {
+	ANALYSIS_JOB_IDLE,
+	ANALYSIS_JOB_QUEUED,
+	ANALYSIS_JOB_RUNNING,
+	ANALYSIS_JOB_DONE,
+};
+
+struct analysis_job {
+	void (*fn)(void *arg) = nullptr;
+	void *arg = nullptr;
+
+	std::atomic<int> state{ANALYSIS_JOB_IDLE};
+	int queue = -1;
+
+	// deadline_ns is set by the submitter; finish_ns is filled in when the
+	// job completes so the owner can account for late results.
+	uint64_t deadline_ns = 0;
+	uint64_t finish_ns = 0;
+	bool ran_inline = false;
+};
+
+// threads < 0 uses half the logical cores, 0 leaves the pool stopped. Each
+// worker applies tuning to itself and logs what the OS allowed.
+void analysis_pool_start(int threads, const thread_tuning &tuning);
+void analysis_pool_stop();
+int analysis_pool_size();
+
+// Queues job, or runs it immediately when the pool is not running. The job
+// must be idle or done.
+void analysis_pool_submit(analysis_job *job);
+
+// Blocks until job is done. Returns false if the job was never submitted.
+bool analysis_pool_wait(analysis_job *job);
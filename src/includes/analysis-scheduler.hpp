@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Process-wide scheduler shared by every analyzer. Each analyzer is given a
+// frame slot when it is created so periodic work lands on different video
+// frames instead of all at once, and analyzers listening to the same audio
+// input share one magnitude spectrum per video frame instead of each running
+// the same FFT.
+//
+// What the slot staggers:
+// - Song-structure frames (every 250 ms, with a novelty pass over the whole
+//   history) are offset by the slot at every governor level.
+// - At governor level 0 the FFT runs every frame while at most
+//   kFullRateAnalyzers analyzers exist. Beyond that each analyzer refreshes
+//   its FFT every other frame in its slot and reuses the last spectrum in
+//   between; bands and smoothing still run every frame.
+// - At governor levels 1 and up the whole analysis tick runs every hop
+//   frames in its slot.
+
+// Number of slots; divisible by every hop the governor uses (1-4).
+static constexpr int kAnalysisSlots = 12;
+
+// Analyzers that may each run their own FFT on every frame.
+static constexpr int kFullRateAnalyzers = 8;
+
+// Returns the least loaded slot and counts the caller in it.
+int analysis_scheduler_acquire_slot();
+void analysis_scheduler_release_slot(int slot);
+
+// True when work with the given period is due on the current video frame for
+// an analyzer in slot. Period 1 is always due.
+bool analysis_scheduler_is_due(int slot, int period);
+
+// Period for FFT refreshes at full analysis rate: 1 while few analyzers are
+// registered, 2 once there are more than kFullRateAnalyzers.
+int analysis_scheduler_fft_period();
+
+// Looks up a spectrum of size bins already computed for input during the
+// current video frame. input is any stable per-input key; 0 never matches.
+bool analysis_scheduler_lookup_spectrum(uintptr_t input, size_t bins, std::vector<float> &mags);
+void analysis_scheduler_publish_spectrum(uintptr_t input, const std::vector<float> &mags);
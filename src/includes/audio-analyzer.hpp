@@ -0,0 +1,153 @@
+#pragma once
+
+#include <obs-module.h>
+
+#include "analysis-pool.hpp"
+#include "song-structure.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <complex>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Everything the OBS audio thread writes on each capture callback. It sits on
+// its own cache lines so the callback does not contend with analysis writes.
+// ring_size is the ring length analysis wants; it and the ring only change
+// under mutex.
+struct alignas(64) audio_ingest {
+	std::atomic<uint32_t> cb_inflight{0};
+
+	std::mutex mutex;
+	std::vector<float> mono_ring;
+	size_t ring_size = 2048;
+	size_t mono_pos = 0;
+	size_t mono_count = 0;
+	float raw_level = 0.0f;
+	float raw_peak = 0.0f;
+};
+
+enum audio_weighting {
+	AUDIO_WEIGHTING_NONE = 0,
+	AUDIO_WEIGHTING_A = 1,
+	AUDIO_WEIGHTING_C = 2,
+};
+
+// One point of the user gain curve; points are kept sorted by frequency.
+struct gain_point {
+	float hz;
+	float db;
+};
+
+// Audio capture + level/spectrum analysis shared by every plugin source and
+// filter. The state is split by owner:
+//  - binding: set from the UI thread under bind_mutex, alive is read by the
+//    audio thread;
+//  - ingest: written by the audio thread, see audio_ingest;
+//  - analysis: everything from react_db down, owned by whichever thread runs
+//    audio_analyzer_tick() and guarded by the owner's lock.
+// The owner's render state lives in the owning source or filter.
+struct audio_analyzer {
+	obs_source_t *owner = nullptr;
+
+	std::mutex bind_mutex;
+	std::string audio_source_uuid;
+	std::string audio_source_name;
+	obs_weak_source_t *audio_weak = nullptr;
+	std::atomic<bool> alive{true};
+
+	audio_ingest ingest;
+
+	alignas(64) float react_db = -55.0f;
+	float peak_db = -6.0f;
+	float attack_ms = 25.0f;
+	float release_ms = 180.0f;
+	uint64_t last_ts_ns = 0;
+
+	float level = 0.0f;
+	float peak = 0.0f;
+	float bass = 0.0f;
+	float mid = 0.0f;
+	float treble = 0.0f;
+	std::array<float, 64> bands{};
+	// Several-second context from the song-structure stage.
+	float section_change = 0.0f;
+	float energy_trend = 0.0f;
+	song_structure structure;
+
+	int fft_size = 2048;
+	int band_count = 64;
+	int sample_rate = 48000;
+
+	// Spectral weighting, applied to the bands only. bin_gain holds the
+	// combined linear gain per FFT bin and is rebuilt when the settings or
+	// the transform length change.
+	int weighting = AUDIO_WEIGHTING_NONE;
+	float tilt_db_per_octave = 0.0f;
+	std::vector<gain_point> gain_curve;
+	std::vector<float> bin_gain;
+	bool bin_gain_dirty = true;
+
+	std::vector<std::complex<float>> fft_twiddles;
+	std::vector<float> fft_window;
+	std::vector<std::complex<float>> fft_buffer;
+	std::vector<float> fft_magnitudes;
+	std::vector<float> ring_snapshot;
+	bool fft_logged_error = false;
+
+	int sched_slot = -1;
+
+	// Pending audio_analyzer_tick_async() work; outputs may only be read
+	// after audio_analyzer_wait().
+	analysis_job job;
+	uint64_t job_now_ns = 0;
+	uint32_t job_late_count = 0;
+	uint64_t job_late_logged_ns = 0;
+
+	// CPU quality governor. Per-tick analysis cost is compared against
+	// cpu_budget_ms and the quality level is stepped with hysteresis; the
+	// gov_shown_* mirrors are what the properties UI reads.
+	float cpu_budget_ms = 1.0f;
+	int gov_level = 0;
+	float gov_cost_ms = 0.0f;
+	int gov_over_ticks = 0;
+	int gov_under_ticks = 0;
+	std::atomic<int> gov_shown_level{0};
+	std::atomic<uint32_t> gov_shown_cost_us{0};
+};
+
+static inline float clamp01(float v)
+{
+	return std::max(0.0f, std::min(1.0f, v));
+}
+
+void audio_analyzer_init(audio_analyzer *a, obs_source_t *owner);
+void audio_analyzer_shutdown(audio_analyzer *a);
+
+void audio_analyzer_attach(audio_analyzer *a);
+void audio_analyzer_detach(audio_analyzer *a);
+
+void audio_analyzer_defaults(obs_data_t *settings);
+void audio_analyzer_add_source_list(obs_properties_t *props);
+// a may be null; when set, the governor's current state is shown read-only.
+void audio_analyzer_add_properties(obs_properties_t *props, const audio_analyzer *a);
+void audio_analyzer_update_settings(audio_analyzer *a, obs_data_t *settings);
+
+// Feeds one block of planar float audio into the analysis ring. Called from
+// the OBS capture callback; usable directly to replay recorded audio.
+void audio_analyzer_push_audio(audio_analyzer *a, const float *left, const float *right, size_t frames, bool muted);
+
+// Advances smoothing and recomputes level/bands. now_ns drives both the
+// smoothing step and the band shuffle, so a fixed clock gives repeatable
+// output for the same input.
+void audio_analyzer_tick(audio_analyzer *a, uint64_t now_ns);
+
+// Queues audio_analyzer_tick() on the analysis pool, after finishing any
+// previous job. Call audio_analyzer_wait() before reading the outputs; it
+// returns false when no job was pending.
+void audio_analyzer_tick_async(audio_analyzer *a, uint64_t now_ns);
+bool audio_analyzer_wait(audio_analyzer *a);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <obs-module.h>
+
+#include "audio-analyzer.hpp"
+#include "shader-effect.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+struct audio_shader_filter {
+	obs_source_t *self = nullptr;
+
+	audio_analyzer analyzer;
+
+	// Starts on its own cache line, away from the analyzer state.
+	alignas(64) std::mutex mutex;
+
+	shader_effect shader;
+	uint64_t uploaded_frame_ts = 0;
+	bool render_logged_no_effect = false;
+	bool render_logged_no_technique = false;
+};
+
+extern "C" void register_audio_shader_filter(void);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <obs-module.h>
+
+#include <string>
+
+// Process-wide list of audio-capable inputs, kept current from the global
+// OBS source_create/destroy/rename and audio activate/deactivate signals, so
+// properties dialogs can list audio sources without walking every source in
+// the collection. Entries are keyed by source UUID, which survives renames.
+
+void audio_source_index_start();
+void audio_source_index_stop();
+
+// Adds every input whose audio is currently active to list, labelled with
+// its name and keyed by its UUID, in creation order.
+void audio_source_index_fill_list(obs_property_t *list);
+
+// Name <-> UUID lookups for indexed sources. Return false when not indexed.
+bool audio_source_index_find_uuid(const char *name, std::string &uuid);
+bool audio_source_index_find_name(const char *uuid, std::string &name);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <obs-module.h>
+
+#include "audio-analyzer.hpp"
+
+#include <mutex>
+
+enum audio_transform_driver {
+	AUDIO_DRIVER_LEVEL = 0,
+	AUDIO_DRIVER_PEAK = 1,
+	AUDIO_DRIVER_BASS = 2,
+	AUDIO_DRIVER_MID = 3,
+	AUDIO_DRIVER_TREBLE = 4,
+	AUDIO_DRIVER_SECTION = 5,
+};
+
+struct audio_transform_filter {
+	obs_source_t *self = nullptr;
+
+	audio_analyzer analyzer;
+
+	// Starts on its own cache line, away from the analyzer state.
+	alignas(64) std::mutex mutex;
+
+	int driver = AUDIO_DRIVER_BASS;
+	float scale_amount = 0.15f;
+	float opacity_amount = 0.0f;
+	float rotation_deg = 0.0f;
+	float offset_x = 0.0f;
+	float offset_y = 0.0f;
+
+	float drive = 0.0f;
+
+	// Render thread only.
+	gs_effect_t *opacity_effect = nullptr;
+	bool opacity_effect_failed = false;
+};
+
+extern "C" void register_audio_transform_filter(void);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <string>
+
+static constexpr int kMaxQualityTiers = 8;
+// Parsing stops after this many bytes, longer lines are skipped and longer
+// labels are cut.
+static constexpr size_t kMaxMetadataBytes = 64 * 1024;
+static constexpr size_t kMaxMetadataLineBytes = 1024;
+static constexpr size_t kMaxMetadataLabelLength = 128;
+
+// Labels and quality tiers from an effect's .ini file; see "Metadata file" in
+// README.md. Missing or unreadable files give the defaults.
+struct effect_metadata {
+	std::string name;
+	std::array<std::string, 8> option_labels{};
+	std::array<std::string, 4> color_labels{};
+	int quality_tiers = 1;
+	bool quality_uniform = false;
+	std::array<std::string, kMaxQualityTiers> tier_labels{};
+};
+
+// Parses .ini text from any stream. At most kMaxMetadataBytes are consumed
+// and no more than kMaxMetadataLineBytes of a line are held, so a huge or
+// newline-free file costs bounded memory and time.
+effect_metadata parse_effect_metadata(std::istream &file);
+
+// Reads "<effect_path>.ini".
+effect_metadata load_effect_metadata(const std::string &effect_path);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <obs-module.h>
+#include <graphics/graphics.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+// Plugin-wide cache of compiled effects, keyed by canonical file path plus a
+// variant string (preprocessor lines prepended to the source). Every source
+// and filter using the same effect shares one compiled copy; the copy is
+// destroyed when its last user releases it. Because the gs_effect_t and its
+// parameters are shared, users must write their whole parameter block just
+// before each draw and never rely on values left from a previous draw.
+// Unless noted otherwise, functions must be called inside the graphics
+// context.
+
+// Parameter handles resolved once at compile time; null when the effect
+// does not declare the uniform.
+struct effect_params {
+	gs_eparam_t *source_size = nullptr;
+	gs_eparam_t *resolution = nullptr;
+	gs_eparam_t *time = nullptr;
+	gs_eparam_t *audio_level = nullptr;
+	gs_eparam_t *audio_peak = nullptr;
+	gs_eparam_t *audio_bass = nullptr;
+	gs_eparam_t *audio_mid = nullptr;
+	gs_eparam_t *audio_treble = nullptr;
+	gs_eparam_t *audio_section_change = nullptr;
+	gs_eparam_t *audio_energy_trend = nullptr;
+	gs_eparam_t *band_count = nullptr;
+	gs_eparam_t *band_texture = nullptr;
+	gs_eparam_t *spectrum_texture = nullptr;
+	gs_eparam_t *quality = nullptr;
+	std::array<gs_eparam_t *, 8> options{};
+	std::array<gs_eparam_t *, 4> colors{};
+
+	// Array uniforms, uploaded with one gs_effect_set_val each.
+	gs_eparam_t *bands = nullptr;
+	size_t bands_len = 0;
+	gs_eparam_t *bands4 = nullptr;
+	size_t bands4_len = 0;
+	gs_eparam_t *features = nullptr;
+	size_t features_len = 0;
+};
+
+// Immutable once compiled, so holders may keep pointers into it. A
+// recompile builds a new entry and marks the old one superseded; holders
+// move over on their next load and the old copy goes away with its last
+// user.
+struct effect_entry {
+	std::string key;
+	std::string path;
+	std::string variant;
+	gs_effect_t *effect = nullptr;
+	bool samples_image = false;
+	effect_params params;
+
+	bool superseded = false;
+	// Compiled in the background and not yet claimed; the registry holds
+	// the only reference until the first acquire takes it over.
+	bool pinned = false;
+	// Preloaded; the registry keeps its own reference until unload or
+	// invalidate, so the effect stays compiled while nobody uses it.
+	bool resident = false;
+	int refs = 0;
+};
+
+// Returns the shared entry for path + variant, compiling it on first use.
+// On failure returns nullptr and fills error; failures are not cached.
+effect_entry *effect_registry_acquire(const std::string &path, const std::string &variant, std::string &error);
+void effect_registry_release(effect_entry *entry);
+
+// Like acquire, but never compiles: returns nullptr when path + variant is
+// not compiled yet.
+effect_entry *effect_registry_try_acquire(const std::string &path, const std::string &variant);
+
+// Queues path + variant to be compiled on the registry's worker thread so a
+// later try_acquire finds it ready. The worker enters the graphics context
+// only for the compile itself. May be called from any thread.
+void effect_registry_compile_async(const std::string &path, const std::string &variant);
+
+// Queues path + variant as a resident compile behind every compile_async
+// request. Preloads are compiled one at a time with a pause after each, so
+// the render thread gets the graphics context back in between. May be
+// called from any thread.
+void effect_registry_preload(const std::string &path, const std::string &variant);
+
+// Stops the worker and drops compiled effects nobody claimed, including
+// resident ones. Called on module unload.
+void effect_registry_stop();
+
+// Forces the next acquire of any variant of path to recompile it, e.g.
+// after the file was edited.
+void effect_registry_invalidate(const std::string &path);
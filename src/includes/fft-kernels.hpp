@@ -0,0 +1,22 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Size-specialised radix-2 FFT kernels for every size the analyzer can run
+// (256 for the most degraded governor step, then the 512-8192 settings).
+// Twiddle and bit-reversal tables are generated at compile time, the first
+// two stages are fused into multiply-free radix-4 butterflies, and all loop
+// bounds are constants so the compiler can unroll and vectorise them.
+using fft_kernel_fn = void (*)(std::complex<float> *data);
+
+// Returns the in-place forward FFT kernel for n, or nullptr when n has no
+// specialisation and the generic path has to be used.
+fft_kernel_fn fft_kernel_for_size(size_t n);
+
+// Generic radix-2 transform for any power-of-two size, used when no kernel is
+// specialised. twiddles must come from fft_build_twiddles() for a.size();
+// returns false when the size or the table does not fit.
+void fft_build_twiddles(std::vector<std::complex<float>> &twiddles, size_t n);
+bool fft_inplace(std::vector<std::complex<float>> &a, const std::vector<std::complex<float>> &twiddles);
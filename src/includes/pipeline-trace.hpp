@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Opt-in span recorder for the audio/render pipeline. Each thread appends to
+// its own fixed ring without locks; pipeline_trace_write() dumps every ring as
+// Chrome trace JSON (chrome://tracing, ui.perfetto.dev). When tracing is off a
+// span costs one relaxed atomic load.
+
+extern std::atomic<bool> g_pipeline_trace_enabled;
+
+static inline bool pipeline_trace_enabled()
+{
+	return g_pipeline_trace_enabled.load(std::memory_order_relaxed);
+}
+
+void pipeline_trace_set_enabled(bool enabled);
+void pipeline_trace_record(const char *name, uint64_t begin_ns, uint64_t end_ns, uint64_t arg);
+
+// Writes all recorded spans to path. Returns the number of spans written, or
+// -1 if the file could not be written.
+long pipeline_trace_write(const char *path);
+
+class pipeline_trace_scope {
+public:
+	explicit pipeline_trace_scope(const char *name, uint64_t arg = 0);
+	~pipeline_trace_scope();
+
+	pipeline_trace_scope(const pipeline_trace_scope &) = delete;
+	pipeline_trace_scope &operator=(const pipeline_trace_scope &) = delete;
+
+private:
+	const char *name_;
+	uint64_t arg_;
+	uint64_t begin_ns_;
+};
+
+#define AW_TRACE_CONCAT_INNER(a, b) a##b
+#define AW_TRACE_CONCAT(a, b) AW_TRACE_CONCAT_INNER(a, b)
+#define AW_TRACE_SCOPE(...) pipeline_trace_scope AW_TRACE_CONCAT(aw_trace_scope_, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "thread-priority.hpp"
+
+// Plugin-wide settings that are not tied to one source, read once at module
+// load from plugin_settings.json in the plugin config folder. Missing keys are
+// written back with their defaults so the file documents itself.
+struct plugin_settings {
+	// Analysis worker threads. -1 picks half the logical cores, 0 keeps
+	// analysis on the thread that renders each source.
+	int analysis_threads = -1;
+
+	// Scheduling for the analysis workers: analysis_priority is "normal",
+	// "high" or "realtime", analysis_affinity a CPU list like "2,3" or "4-7".
+	thread_tuning analysis_tuning;
+
+	// Compile the bundled effects in the background at load.
+	bool preload_effects = true;
+};
+
+void plugin_settings_load();
+const plugin_settings &plugin_settings_get();
@@ -0,0 +1,91 @@
+#pragma once
+
+// Static USDT/SDT probe points for perf and bpftrace, provider "audio_wave".
+// Probes compile to a single nop when nothing is attached. Each probe has an
+// SDT semaphore that the tracer raises while attached, so the durations the
+// exit probes report only read the clock while someone is listening. Builds
+// without <sys/sdt.h> (or with ENABLE_USDT_PROBES=OFF) drop them entirely.
+//
+//   bpftrace -e 'usdt:*audio-wave.so:audio_wave:source_render_exit { @[arg0] = hist(arg1); }'
+
+#include <cstdint>
+
+#if defined(__linux__) && !defined(AW_DISABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define AW_HAVE_USDT 1
+#endif
+#endif
+
+// Every probe the plugin fires. A probe missing here has no semaphore and
+// fails to link.
+#define AW_PROBE_LIST(X)            \
+	X(analysis_bands)           \
+	X(analysis_entry)           \
+	X(analysis_exit)            \
+	X(analysis_fft)             \
+	X(audio_capture_entry)      \
+	X(audio_capture_exit)       \
+	X(effect_load_entry)        \
+	X(effect_load_exit)         \
+	X(source_render_entry)      \
+	X(source_render_exit)       \
+	X(update_band_texture_entry) \
+	X(update_band_texture_exit)
+
+#ifdef AW_HAVE_USDT
+
+#include <util/platform.h>
+
+// Defined in probes.cpp, in the .probes section where tracers look for them.
+#define AW_PROBE_DECLARE_SEMAPHORE(name) extern "C" volatile unsigned short audio_wave_##name##_semaphore;
+AW_PROBE_LIST(AW_PROBE_DECLARE_SEMAPHORE)
+#undef AW_PROBE_DECLARE_SEMAPHORE
+
+#define AW_PROBE_ENABLED(name) __builtin_expect(audio_wave_##name##_semaphore != 0, 0)
+
+// Start time for a probe that reports a duration, or 0 while it is off.
+#define AW_PROBE_CLOCK(name) (AW_PROBE_ENABLED(name) ? os_gettime_ns() : uint64_t(0))
+
+static inline uint64_t aw_probe_elapsed(uint64_t t0)
+{
+	return t0 ? os_gettime_ns() - t0 : 0;
+}
+
+#define AW_PROBE1(name, a) DTRACE_PROBE1(audio_wave, name, a)
+#define AW_PROBE2(name, a, b) DTRACE_PROBE2(audio_wave, name, a, b)
+#define AW_PROBE3(name, a, b, c) DTRACE_PROBE3(audio_wave, name, a, b, c)
+
+#else
+
+#define AW_PROBE_ENABLED(name) false
+#define AW_PROBE_CLOCK(name) uint64_t(0)
+
+static inline uint64_t aw_probe_elapsed(uint64_t)
+{
+	return 0;
+}
+
+#define AW_PROBE1(name, a) \
+	do {               \
+		(void)(a); \
+	} while (0)
+#define AW_PROBE2(name, a, b) \
+	do {                  \
+		(void)(a);    \
+		(void)(b);    \
+	} while (0)
+#define AW_PROBE3(name, a, b, c) \
+	do {                     \
+		(void)(a);       \
+		(void)(b);       \
+		(void)(c);       \
+	} while (0)
+
+#endif
+
+static inline uintptr_t aw_probe_id(const void *p)
+{
+	return reinterpret_cast<uintptr_t>(p);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <obs-module.h>
+#include <graphics/graphics.h>
+
+#include <atomic>
+#include <cstdint>
+
+// Per-source GPU frame-budget governor. Render cost is measured with GPU
+// timer queries when the graphics backend provides them, otherwise with the
+// CPU time spent submitting the draw. Sustained overruns lower the internal
+// render scale first, then the effect's quality tier (when it declares
+// tiers) and then the shader frame rate, within the configured bounds;
+// sources that are only on preview get half the budget so program output
+// keeps its quality longest. All fields except the shown_* mirrors are owned
+// by the graphics thread under the owner's render lock.
+struct render_governor {
+	float budget_ms = 4.0f;
+	int min_scale_pct = 50;
+	int min_fps = 15;
+
+	int scale_step = 0;
+	int quality_drop = 0;
+	int max_quality_drop = 0;
+	int frame_divisor = 1;
+	int frame_phase = 0;
+	float cost_ms = 0.0f;
+	int over_samples = 0;
+	int under_samples = 0;
+
+	gs_timer_range_t *timer_range = nullptr;
+	gs_timer_t *timer = nullptr;
+	bool timer_failed = false;
+	bool timer_pending = false;
+	bool timer_running = false;
+	uint64_t cpu_t0 = 0;
+
+	std::atomic<int> shown_scale_pct{100};
+	std::atomic<int> shown_fps{0};
+	std::atomic<int> shown_quality_drop{0};
+	std::atomic<uint32_t> shown_cost_us{0};
+	std::atomic<bool> shown_gpu_timing{false};
+};
+
+void render_governor_defaults(obs_data_t *settings);
+// g may be null; when set, the governor's current state is shown read-only.
+void render_governor_add_properties(obs_properties_t *props, const render_governor *g);
+void render_governor_update_settings(render_governor *g, obs_data_t *settings);
+
+// Called once per new video frame; false means the previous texture should be
+// shown again because the shader frame rate is currently reduced.
+bool render_governor_should_render(render_governor *g);
+
+// Internal render size for a width x height output at the current scale.
+void render_governor_scaled_size(const render_governor *g, uint32_t width, uint32_t height, uint32_t *out_width,
+				 uint32_t *out_height);
+
+// Number of quality tiers below the top one the current effect offers; the
+// governor only lowers the tier within that range. Returns the current
+// number of tiers to drop.
+int render_governor_quality_drop(render_governor *g, int max_drop);
+
+// Bracket the GPU work of one rendered frame. end() folds in any finished
+// measurement and steps the scale/rate for owner.
+void render_governor_begin(render_governor *g);
+void render_governor_end(render_governor *g, obs_source_t *owner);
+
+// Must be called inside the graphics context.
+void render_governor_destroy(render_governor *g);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <obs-module.h>
+#include <graphics/graphics.h>
+
+#include "audio-analyzer.hpp"
+#include "effect-registry.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Selected .effect plus the option/color block and 64x1 band texture fed to
+// it. Shared by the shader source and the shader filter; every function that
+// touches gs_* objects must be called inside the graphics context. The
+// compiled effect comes from the effect registry and may be shared with
+// other instances; effect and samples_image mirror the held entry.
+struct shader_effect {
+	std::string effect_path;
+	effect_entry *entry = nullptr;
+	gs_effect_t *effect = nullptr;
+	std::string effect_error;
+	bool reload_effect = true;
+	bool recompile = false;
+	bool samples_image = false;
+
+	// Quality tiers from the effect's .ini [quality] section; 1 means none.
+	// quality_setting is the manual choice (0 = auto) and quality_tier the
+	// tier being drawn. quality_pending is a tier queued for a background
+	// compile.
+	int quality_tiers = 1;
+	bool quality_uniform = false;
+	int quality_setting = 0;
+	int quality_tier = 0;
+	int quality_pending = 0;
+
+	gs_texture_t *band_texture = nullptr;
+	std::array<uint8_t, 64 * 4> band_texture_pixels{};
+
+	std::array<float, 8> options{};
+	std::array<uint32_t, 4> colors{0xFFFFFFu, 0xFFD200u, 0xBB509Du, 0xAC3CFFu};
+};
+
+std::string shader_effect_module_path(const char *module_file);
+
+// Queues every bundled effect under data/effects for a resident background
+// compile at the variant a new instance loads first, then the lower
+// define-mode quality tiers, so picking a bundled effect never compiles on
+// the render thread.
+void shader_effect_preload_bundled();
+void shader_effect_defaults(obs_data_t *settings, const char *default_module_file);
+obs_property_t *shader_effect_add_path_property(obs_properties_t *props, obs_property_modified_t modified);
+const char *shader_effect_settings_path(obs_data_t *settings);
+void shader_effect_rebuild_controls(obs_properties_t *props, const std::string &effect_path);
+
+// Returns true when the selected effect path changed.
+bool shader_effect_update_settings(shader_effect *fx, obs_data_t *settings);
+
+// Queues a reload that recompiles the file from disk for every instance
+// sharing it, instead of reusing the registry's compiled copy.
+void shader_effect_request_recompile(shader_effect *fx);
+void shader_effect_load_if_needed(shader_effect *fx);
+
+// Tier automatic quality would use for a width x height canvas before any
+// render-budget drop, or 0 when the tier is fixed (no tiers or a manual
+// choice).
+int shader_effect_auto_tier(const shader_effect *fx, uint32_t width, uint32_t height);
+
+// Switches to tier (0 = the fixed tier). Define-mode tiers that are not
+// compiled yet are queued for a background compile and the current tier
+// keeps drawing meanwhile.
+void shader_effect_select_tier(shader_effect *fx, int tier);
+const char *shader_effect_technique_name(const shader_effect *fx);
+gs_technique_t *shader_effect_technique(const shader_effect *fx);
+void shader_effect_update_band_texture(shader_effect *fx, const audio_analyzer &a, obs_source_t *owner);
+void shader_effect_set_params(shader_effect *fx, const audio_analyzer &a, uint32_t width, uint32_t height);
+void shader_effect_destroy(shader_effect *fx);
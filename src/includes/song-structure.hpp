@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Song-structure stage fed by the analyzer after each analysed tick. Band
+// values are folded into a compact timbre vector plus an energy value and
+// averaged into fixed-rate history frames, so the result does not depend on
+// the video frame rate or the governor hop. Whenever a frame is completed, a
+// checkerboard kernel over the frames' self-similarity gives a novelty value
+// that rises as soon as the newest second stops resembling the seconds before
+// it. The kernel is lopsided on purpose: a short recent side reacts to a drop
+// within about a second, a long older side keeps one odd bar from counting
+// as a new section. The work per completed frame is a fixed
+// kSongFrames^2 / 2 distance evaluations, whatever the FFT size or band
+// count.
+
+static constexpr int kSongDims = 8;
+static constexpr uint64_t kSongFrameNs = 250000000;
+static constexpr int kSongFrames = 24;
+// Newest frames on the recent side of the kernel; the rest are the older side.
+static constexpr int kSongRecentFrames = 4;
+
+struct song_frame {
+	std::array<float, kSongDims> timbre{};
+	float energy = 0.0f;
+};
+
+struct song_structure {
+	// Fixed ring of completed frames; pos is the next slot to write.
+	std::array<song_frame, kSongFrames> frames{};
+	int pos = 0;
+	int count = 0;
+
+	// Running average for the frame being built.
+	song_frame accum;
+	int accum_n = 0;
+	uint64_t frame_start_ns = 0;
+	// Offset of frame boundaries, so analyzers created together do not all
+	// complete a frame on the same video frame.
+	uint64_t phase_ns = 0;
+
+	// Adaptive threshold: slow averages of the novelty and its deviation.
+	float novelty = 0.0f;
+	float novelty_mean = 0.0f;
+	float novelty_dev = 0.0f;
+	uint64_t last_change_ns = 0;
+	float trend_target = 0.0f;
+
+	// Outputs. section_change jumps to 1 on a detected boundary and decays;
+	// energy_trend is -1..1, positive while the energy is building.
+	float section_change = 0.0f;
+	float energy_trend = 0.0f;
+};
+
+// Adds one analysed tick. raw_bands holds band_count values in 0..1 and
+// energy is the unsmoothed level in 0..1.
+void song_structure_update(song_structure *s, const float *raw_bands, int band_count, float energy, uint64_t now_ns,
+			   float dt);
+
+// Lets the outputs relax when there is no audio to analyse.
+void song_structure_idle(song_structure *s, float dt);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Optional scheduling tweaks for the analysis workers, configured in
+// plugin_settings.json. Every step falls back when the OS refuses it, and the
+// outcome is returned as text for the log.
+
+enum thread_priority_level {
+	THREAD_PRIORITY_LEVEL_NORMAL,
+	THREAD_PRIORITY_LEVEL_HIGH,
+	THREAD_PRIORITY_LEVEL_REALTIME,
+};
+
+struct thread_tuning {
+	thread_priority_level priority = THREAD_PRIORITY_LEVEL_NORMAL;
+	// Logical CPUs the workers may run on; empty leaves affinity alone.
+	std::vector<int> cpus;
+};
+
+// "normal", "high" or "realtime"; anything else is normal.
+thread_priority_level thread_priority_parse(const char *text);
+const char *thread_priority_name(thread_priority_level level);
+
+// Parses a CPU list such as "2,3" or "4-7,10". Invalid entries are skipped.
+std::vector<int> thread_affinity_parse(const char *text);
+
+// Applies tuning to the calling thread and returns what actually took effect.
+std::string thread_tuning_apply_current(const thread_tuning &tuning);
@@ -0,0 +1,134 @@
+#include "includes/pipeline-trace.hpp"
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static constexpr size_t kTraceEventsPerThread = 16384;
+
+struct trace_event {
+	const char *name;
+	uint64_t begin_ns;
+	uint64_t end_ns;
+	uint64_t arg;
+};
+
+// Single producer (the owning thread), read by the dumper. Slots that are
+// being overwritten while a dump runs may come out torn; the dumper skips the
+// oldest part of a full ring to keep that window away from the writer.
+struct trace_buffer {
+	uint32_t tid = 0;
+	std::atomic<uint64_t> write_index{0};
+	std::array<trace_event, kTraceEventsPerThread> events{};
+};
+
+std::atomic<bool> g_pipeline_trace_enabled{false};
+
+static std::mutex g_buffers_mutex;
+static std::vector<std::unique_ptr<trace_buffer>> g_buffers;
+static uint64_t g_trace_origin_ns = 0;
+
+static thread_local trace_buffer *t_buffer = nullptr;
+
+static trace_buffer *thread_buffer()
+{
+	if (t_buffer)
+		return t_buffer;
+
+	auto buffer = std::make_unique<trace_buffer>();
+	std::lock_guard<std::mutex> lock(g_buffers_mutex);
+	buffer->tid = uint32_t(g_buffers.size() + 1);
+	t_buffer = buffer.get();
+	g_buffers.push_back(std::move(buffer));
+	return t_buffer;
+}
+
+// Rings are not cleared on start; spans older than the trace origin are
+// simply skipped when dumping.
+void pipeline_trace_set_enabled(bool enabled)
+{
+	if (enabled) {
+		std::lock_guard<std::mutex> lock(g_buffers_mutex);
+		g_trace_origin_ns = os_gettime_ns();
+	}
+	g_pipeline_trace_enabled.store(enabled, std::memory_order_release);
+	BLOG(LOG_INFO, "Pipeline trace %s", enabled ? "started" : "stopped");
+}
+
+void pipeline_trace_record(const char *name, uint64_t begin_ns, uint64_t end_ns, uint64_t arg)
+{
+	trace_buffer *buffer = thread_buffer();
+	const uint64_t index = buffer->write_index.load(std::memory_order_relaxed);
+	buffer->events[index % kTraceEventsPerThread] = {name, begin_ns, end_ns, arg};
+	buffer->write_index.store(index + 1, std::memory_order_release);
+}
+
+pipeline_trace_scope::pipeline_trace_scope(const char *name, uint64_t arg)
+	: name_(name),
+	  arg_(arg),
+	  begin_ns_(pipeline_trace_enabled() ? os_gettime_ns() : 0)
+{
+}
+
+pipeline_trace_scope::~pipeline_trace_scope()
+{
+	if (begin_ns_ && pipeline_trace_enabled())
+		pipeline_trace_record(name_, begin_ns_, os_gettime_ns(), arg_);
+}
+
+long pipeline_trace_write(const char *path)
+{
+	if (!path || !*path)
+		return -1;
+
+	FILE *file = os_fopen(path, "wb");
+	if (!file) {
+		BLOG(LOG_ERROR, "Could not open trace file '%s'", path);
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(g_buffers_mutex);
+	const uint64_t origin = g_trace_origin_ns;
+
+	long written = 0;
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+	for (const auto &buffer : g_buffers) {
+		const uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+		uint64_t begin = 0;
+		if (end > kTraceEventsPerThread)
+			begin = end - kTraceEventsPerThread + kTraceEventsPerThread / 16;
+
+		for (uint64_t i = begin; i < end; ++i) {
+			const trace_event ev = buffer->events[i % kTraceEventsPerThread];
+			if (!ev.name || ev.begin_ns < origin || ev.end_ns < ev.begin_ns)
+				continue;
+
+			std::fprintf(file,
+				     "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32
+				     ",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"value\":%" PRIu64 "}}",
+				     written ? "," : "", ev.name, buffer->tid, double(ev.begin_ns - origin) / 1000.0,
+				     double(ev.end_ns - ev.begin_ns) / 1000.0, ev.arg);
+			++written;
+		}
+	}
+	std::fputs("]}\n", file);
+
+	const bool ok = std::fclose(file) == 0;
+	if (!ok) {
+		BLOG(LOG_ERROR, "Could not write trace file '%s'", path);
+		return -1;
+	}
+
+	BLOG(LOG_INFO, "Wrote %ld pipeline trace spans to '%s'", written, path);
+	return written;
+}
@@ -1,19 +1,36 @@
 #include <obs-module.h>
 #include "includes/config.hpp"
+#include "includes/analysis-pool.hpp"
+#include "includes/audio-source-index.hpp"
+#include "includes/effect-registry.hpp"
+#include "includes/plugin-settings.hpp"
+#include "includes/shader-effect.hpp"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
 
 extern "C" void register_audio_shader_source(void);
+extern "C" void register_audio_transform_filter(void);
+extern "C" void register_audio_shader_filter(void);
 
 bool obs_module_load(void)
 {
 	blog(LOG_INFO, "[%s] plugin loaded successfully (version %s)", PLUGIN_NAME, PLUGIN_VERSION);
+	plugin_settings_load();
+	analysis_pool_start(plugin_settings_get().analysis_threads, plugin_settings_get().analysis_tuning);
+	audio_source_index_start();
 	register_audio_shader_source();
+	register_audio_transform_filter();
+	register_audio_shader_filter();
+	if (plugin_settings_get().preload_effects)
+		shader_effect_preload_bundled();
 	return true;
 }
 
 void obs_module_unload(void)
 {
+	audio_source_index_stop();
+	effect_registry_stop();
+	analysis_pool_stop();
 	blog(LOG_INFO, "[%s] plugin unloaded", PLUGIN_NAME);
 }
@@ -0,0 +1,76 @@
+#include "includes/plugin-settings.hpp"
+
+#include <obs-module.h>
+
+#include <algorithm>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *kSettingsFile = "plugin_settings.json";
+
+static const char *S_ANALYSIS_THREADS = "analysis_threads";
+static const char *S_ANALYSIS_PRIORITY = "analysis_priority";
+static const char *S_ANALYSIS_AFFINITY = "analysis_affinity";
+static const char *S_PRELOAD_EFFECTS = "preload_effects";
+
+static plugin_settings g_plugin_settings;
+
+static int load_int(obs_data_t *data, const char *key, int fallback, int min_value, int max_value)
+{
+	if (!obs_data_has_user_value(data, key))
+		obs_data_set_int(data, key, fallback);
+	return std::clamp((int)obs_data_get_int(data, key), min_value, max_value);
+}
+
+static bool load_bool(obs_data_t *data, const char *key, bool fallback)
+{
+	if (!obs_data_has_user_value(data, key))
+		obs_data_set_bool(data, key, fallback);
+	return obs_data_get_bool(data, key);
+}
+
+static const char *load_string(obs_data_t *data, const char *key, const char *fallback)
+{
+	if (!obs_data_has_user_value(data, key))
+		obs_data_set_string(data, key, fallback);
+	return obs_data_get_string(data, key);
+}
+
+void plugin_settings_load()
+{
+	char *dir = obs_module_config_path("");
+	char *path = obs_module_config_path(kSettingsFile);
+	if (!dir || !path) {
+		bfree(dir);
+		bfree(path);
+		return;
+	}
+
+	os_mkdirs(dir);
+	obs_data_t *data = obs_data_create_from_json_file_safe(path, "bak");
+	if (!data)
+		data = obs_data_create();
+
+	plugin_settings next;
+	next.analysis_threads = load_int(data, S_ANALYSIS_THREADS, next.analysis_threads, -1, 16);
+	next.analysis_tuning.priority = thread_priority_parse(load_string(data, S_ANALYSIS_PRIORITY, "normal"));
+	next.analysis_tuning.cpus = thread_affinity_parse(load_string(data, S_ANALYSIS_AFFINITY, ""));
+	next.preload_effects = load_bool(data, S_PRELOAD_EFFECTS, next.preload_effects);
+	g_plugin_settings = next;
+
+	if (!obs_data_save_json_safe(data, path, "tmp", "bak"))
+		BLOG(LOG_WARNING, "Could not write plugin settings to '%s'", path);
+	else
+		BLOG(LOG_INFO, "Plugin settings loaded from '%s'", path);
+
+	obs_data_release(data);
+	bfree(dir);
+	bfree(path);
+}
+
+const plugin_settings &plugin_settings_get()
+{
+	return g_plugin_settings;
+}
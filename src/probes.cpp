@@ -0,0 +1,14 @@
+#include "includes/probes.hpp"
+
+#ifdef AW_HAVE_USDT
+
+// SDT semaphores, one per probe in AW_PROBE_LIST. A tracer increments a
+// probe's semaphore while it is attached; AW_PROBE_ENABLED() reads it.
+extern "C" {
+#define AW_PROBE_DEFINE_SEMAPHORE(name) \
+	__attribute__((section(".probes"), used)) volatile unsigned short audio_wave_##name##_semaphore = 0;
+AW_PROBE_LIST(AW_PROBE_DEFINE_SEMAPHORE)
+#undef AW_PROBE_DEFINE_SEMAPHORE
+}
+
+#endif
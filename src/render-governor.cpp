@@ -0,0 +1,267 @@
+#include "includes/render-governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *S_GPU_BUDGET_MS = "gpu_budget_ms";
+static const char *S_MIN_RENDER_SCALE = "min_render_scale";
+static const char *S_MIN_SHADER_FPS = "min_shader_fps";
+
+// Render scale ladder in percent. The governor only walks down to the last
+// entry that is still >= the configured minimum.
+static const int kScaleSteps[] = {100, 85, 70, 60, 50, 40, 33, 25};
+static constexpr int kScaleStepCount = int(sizeof(kScaleSteps) / sizeof(kScaleSteps[0]));
+
+// Timer samples arrive every other frame. Degrade after ~20 samples over
+// budget, restore only after ~90 samples well under it.
+static constexpr int kDegradeSamples = 20;
+static constexpr int kRestoreSamples = 90;
+static constexpr float kRestoreRatio = 0.4f;
+static constexpr float kPreviewBudgetFactor = 0.5f;
+
+static double video_fps()
+{
+	obs_video_info ovi = {};
+	if (obs_get_video_info(&ovi) && ovi.fps_num > 0 && ovi.fps_den > 0)
+		return double(ovi.fps_num) / double(ovi.fps_den);
+	return 30.0;
+}
+
+static int max_scale_step(const render_governor *g)
+{
+	int step = 0;
+	while (step + 1 < kScaleStepCount && kScaleSteps[step + 1] >= g->min_scale_pct)
+		++step;
+	return step;
+}
+
+static int max_frame_divisor(const render_governor *g)
+{
+	return std::max(1, int(std::floor(video_fps() / double(std::max(1, g->min_fps)))));
+}
+
+static void publish_state(render_governor *g)
+{
+	g->shown_scale_pct.store(kScaleSteps[g->scale_step], std::memory_order_relaxed);
+	g->shown_fps.store(int(std::lround(video_fps() / double(g->frame_divisor))), std::memory_order_relaxed);
+	g->shown_quality_drop.store(g->quality_drop, std::memory_order_relaxed);
+}
+
+static void set_state(render_governor *g, obs_source_t *owner, int scale_step, int quality_drop, int frame_divisor,
+		      const char *why)
+{
+	if (scale_step == g->scale_step && quality_drop == g->quality_drop && frame_divisor == g->frame_divisor)
+		return;
+
+	g->scale_step = scale_step;
+	g->quality_drop = quality_drop;
+	g->frame_divisor = frame_divisor;
+	g->frame_phase = 0;
+	g->over_samples = 0;
+	g->under_samples = 0;
+	g->cost_ms = 0.0f;
+	publish_state(g);
+
+	const char *name = owner ? obs_source_get_name(owner) : "";
+	BLOG(LOG_INFO, "'%s': %s, render scale %d%%, quality -%d, shader rate %d fps", name ? name : "", why,
+	     kScaleSteps[scale_step], quality_drop, g->shown_fps.load(std::memory_order_relaxed));
+}
+
+static void record_sample(render_governor *g, obs_source_t *owner, double render_ms)
+{
+	const float per_frame_ms = float(render_ms) / float(g->frame_divisor);
+	g->cost_ms = g->cost_ms <= 0.0f ? per_frame_ms : g->cost_ms * 0.8f + per_frame_ms * 0.2f;
+	g->shown_cost_us.store(uint32_t(g->cost_ms * 1000.0f), std::memory_order_relaxed);
+
+	if (g->budget_ms <= 0.0f) {
+		set_state(g, owner, 0, 0, 1, "render budget disabled");
+		return;
+	}
+
+	const bool on_program = owner && obs_source_active(owner);
+	const float budget = g->budget_ms * (on_program ? 1.0f : kPreviewBudgetFactor);
+
+	if (g->cost_ms > budget) {
+		g->under_samples = 0;
+		if (++g->over_samples < kDegradeSamples)
+			return;
+		g->over_samples = 0;
+
+		if (g->scale_step < max_scale_step(g))
+			set_state(g, owner, g->scale_step + 1, g->quality_drop, g->frame_divisor, "over render budget");
+		else if (g->quality_drop < g->max_quality_drop)
+			set_state(g, owner, g->scale_step, g->quality_drop + 1, g->frame_divisor, "over render budget");
+		else if (g->frame_divisor < max_frame_divisor(g))
+			set_state(g, owner, g->scale_step, g->quality_drop, g->frame_divisor + 1, "over render budget");
+	} else if (g->cost_ms < budget * kRestoreRatio) {
+		g->over_samples = 0;
+		if (++g->under_samples < kRestoreSamples)
+			return;
+		g->under_samples = 0;
+
+		// Frame rate comes back first, then quality, then resolution.
+		if (g->frame_divisor > 1)
+			set_state(g, owner, g->scale_step, g->quality_drop, g->frame_divisor - 1, "render headroom");
+		else if (g->quality_drop > 0)
+			set_state(g, owner, g->scale_step, g->quality_drop - 1, g->frame_divisor, "render headroom");
+		else if (g->scale_step > 0)
+			set_state(g, owner, g->scale_step - 1, g->quality_drop, g->frame_divisor, "render headroom");
+	} else {
+		g->over_samples = 0;
+		g->under_samples = 0;
+	}
+}
+
+void render_governor_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_double(settings, S_GPU_BUDGET_MS, 4.0);
+	obs_data_set_default_int(settings, S_MIN_RENDER_SCALE, 50);
+	obs_data_set_default_int(settings, S_MIN_SHADER_FPS, 15);
+}
+
+void render_governor_add_properties(obs_properties_t *props, const render_governor *g)
+{
+	obs_property_t *budget =
+		obs_properties_add_float_slider(props, S_GPU_BUDGET_MS, "Render Budget (ms/frame)", 0.0, 33.0, 0.1);
+	obs_property_set_long_description(budget, "Render scale, then effect quality tier, then shader frame "
+						  "rate are lowered while rendering stays over this budget. "
+						  "Sources only on preview get half of it. 0 disables.");
+	obs_properties_add_int_slider(props, S_MIN_RENDER_SCALE, "Minimum Render Scale (%)", 25, 100, 5);
+	obs_properties_add_int_slider(props, S_MIN_SHADER_FPS, "Minimum Shader FPS", 5, 60, 1);
+
+	if (g) {
+		char status[160];
+		snprintf(status, sizeof(status), "Render: %d%% scale, quality -%d, %d fps (%.2f ms/frame, %s timing)",
+			 g->shown_scale_pct.load(std::memory_order_relaxed),
+			 g->shown_quality_drop.load(std::memory_order_relaxed), g->shown_fps.load(std::memory_order_relaxed),
+			 double(g->shown_cost_us.load(std::memory_order_relaxed)) / 1000.0,
+			 g->shown_gpu_timing.load(std::memory_order_relaxed) ? "GPU" : "CPU");
+		obs_properties_add_text(props, "render_governor_status", status, OBS_TEXT_INFO);
+	}
+}
+
+void render_governor_update_settings(render_governor *g, obs_data_t *settings)
+{
+	if (!g)
+		return;
+
+	g->budget_ms = std::max(0.0f, float(obs_data_get_double(settings, S_GPU_BUDGET_MS)));
+	g->min_scale_pct = std::clamp<int>((int)obs_data_get_int(settings, S_MIN_RENDER_SCALE), 25, 100);
+	g->min_fps = std::clamp<int>((int)obs_data_get_int(settings, S_MIN_SHADER_FPS), 5, 60);
+
+	// Pull the current state back inside the new bounds.
+	if (g->budget_ms <= 0.0f) {
+		g->scale_step = 0;
+		g->quality_drop = 0;
+		g->frame_divisor = 1;
+	} else {
+		g->scale_step = std::min(g->scale_step, max_scale_step(g));
+		g->frame_divisor = std::min(g->frame_divisor, max_frame_divisor(g));
+	}
+	g->frame_phase = 0;
+	g->over_samples = 0;
+	g->under_samples = 0;
+	publish_state(g);
+}
+
+int render_governor_quality_drop(render_governor *g, int max_drop)
+{
+	g->max_quality_drop = std::max(0, max_drop);
+	if (g->quality_drop > g->max_quality_drop) {
+		g->quality_drop = g->max_quality_drop;
+		publish_state(g);
+	}
+	return g->quality_drop;
+}
+
+bool render_governor_should_render(render_governor *g)
+{
+	if (g->frame_divisor <= 1)
+		return true;
+	g->frame_phase = (g->frame_phase + 1) % g->frame_divisor;
+	return g->frame_phase == 0;
+}
+
+void render_governor_scaled_size(const render_governor *g, uint32_t width, uint32_t height, uint32_t *out_width,
+				 uint32_t *out_height)
+{
+	const uint32_t pct = (uint32_t)kScaleSteps[g->scale_step];
+	*out_width = std::max<uint32_t>(16u, width * pct / 100u);
+	*out_height = std::max<uint32_t>(16u, height * pct / 100u);
+}
+
+void render_governor_begin(render_governor *g)
+{
+	if (!g->timer_range && !g->timer_failed) {
+		g->timer_range = gs_timer_range_create();
+		g->timer = gs_timer_create();
+		if (!g->timer_range || !g->timer) {
+			render_governor_destroy(g);
+			g->timer_failed = true;
+			BLOG(LOG_INFO, "GPU timer queries unavailable; render governor uses CPU submit time");
+		}
+		g->shown_gpu_timing.store(!g->timer_failed, std::memory_order_relaxed);
+	}
+
+	if (g->timer_failed) {
+		g->cpu_t0 = os_gettime_ns();
+		return;
+	}
+
+	// Only one query is in flight; frames rendered while it is pending are
+	// simply not measured.
+	if (!g->timer_pending) {
+		gs_timer_range_begin(g->timer_range);
+		gs_timer_begin(g->timer);
+		g->timer_running = true;
+	}
+}
+
+void render_governor_end(render_governor *g, obs_source_t *owner)
+{
+	if (g->timer_failed) {
+		record_sample(g, owner, double(os_gettime_ns() - g->cpu_t0) / 1000000.0);
+		return;
+	}
+
+	if (g->timer_running) {
+		gs_timer_end(g->timer);
+		gs_timer_range_end(g->timer_range);
+		g->timer_running = false;
+		g->timer_pending = true;
+	}
+
+	if (!g->timer_pending)
+		return;
+
+	bool disjoint = false;
+	uint64_t frequency = 0;
+	uint64_t ticks = 0;
+	if (!gs_timer_range_get_data(g->timer_range, &disjoint, &frequency) || !gs_timer_get_data(g->timer, &ticks))
+		return;
+
+	g->timer_pending = false;
+	if (!disjoint && frequency > 0)
+		record_sample(g, owner, double(ticks) * 1000.0 / double(frequency));
+}
+
+void render_governor_destroy(render_governor *g)
+{
+	if (!g)
+		return;
+	if (g->timer) {
+		gs_timer_destroy(g->timer);
+		g->timer = nullptr;
+	}
+	if (g->timer_range) {
+		gs_timer_range_destroy(g->timer_range);
+		g->timer_range = nullptr;
+	}
+	g->timer_pending = false;
+	g->timer_running = false;
+}
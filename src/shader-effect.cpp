@@ -0,0 +1,461 @@
+#include "includes/shader-effect.hpp"
+#include "includes/effect-metadata.hpp"
+#include "includes/pipeline-trace.hpp"
+#include "includes/probes.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <util/platform.h>
+
+#define BLOG(level, fmt, ...) blog(level, "[audio-shader-engine] " fmt, ##__VA_ARGS__)
+
+static const char *S_EFFECT_PATH = "effect_path";
+static const char *S_OPTION_PREFIX = "option";
+static const char *S_COLOR_PREFIX = "color";
+static const char *S_QUALITY_TIER = "quality_tier";
+
+// Auto quality drops one tier for each of these canvas sizes (in pixels)
+// the source exceeds: 1080p and 1440p.
+static const uint64_t kTierPixelThresholds[] = {1920ull * 1080ull, 2560ull * 1440ull};
+
+static void color_to_vec4(uint32_t color, vec4 *out)
+{
+	const float r = float(color & 0xFFu) / 255.0f;
+	const float g = float((color >> 8) & 0xFFu) / 255.0f;
+	const float b = float((color >> 16) & 0xFFu) / 255.0f;
+	vec4_set(out, r, g, b, 1.0f);
+}
+
+std::string shader_effect_module_path(const char *module_file)
+{
+	char *path = obs_module_file(module_file);
+	if (!path)
+		return {};
+	std::string result = path;
+	bfree(path);
+	return result;
+}
+
+void shader_effect_rebuild_controls(obs_properties_t *props, const std::string &effect_path)
+{
+	if (!props)
+		return;
+
+	obs_properties_remove_by_name(props, "shader_options");
+
+	effect_metadata meta = load_effect_metadata(effect_path);
+	obs_properties_t *shader_opts = obs_properties_create();
+	bool any_control = false;
+
+	for (int i = 1; i <= 8; ++i) {
+		const std::string &label = meta.option_labels[(size_t)i - 1];
+		if (label.empty())
+			continue;
+		char key[32];
+		snprintf(key, sizeof(key), "%s%d", S_OPTION_PREFIX, i);
+		obs_properties_add_float_slider(shader_opts, key, label.c_str(), 0.0, 1.0, 0.001);
+		any_control = true;
+	}
+
+	for (int i = 1; i <= 4; ++i) {
+		const std::string &label = meta.color_labels[(size_t)i - 1];
+		if (label.empty())
+			continue;
+		char key[32];
+		snprintf(key, sizeof(key), "%s%d", S_COLOR_PREFIX, i);
+		obs_properties_add_color(shader_opts, key, label.c_str());
+		any_control = true;
+	}
+
+	if (meta.quality_tiers > 1) {
+		obs_property_t *quality = obs_properties_add_list(shader_opts, S_QUALITY_TIER, "Effect Quality",
+								  OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(quality, "Auto", 0);
+		for (int i = meta.quality_tiers; i >= 1; --i) {
+			const std::string &label = meta.tier_labels[(size_t)i - 1];
+			char fallback[32];
+			snprintf(fallback, sizeof(fallback), "Tier %d", i);
+			obs_property_list_add_int(quality, label.empty() ? fallback : label.c_str(), i);
+		}
+		obs_property_set_long_description(quality, "Auto uses a lower tier on canvases above 1080p and lets the "
+							   "render budget lower it further.");
+		any_control = true;
+	}
+
+	if (!any_control) {
+		obs_properties_add_text(
+			shader_opts, "no_effect_controls",
+			"This effect has no named controls. Add a matching .effect.ini file to expose sliders/colors.",
+			OBS_TEXT_INFO);
+	}
+
+	std::string group_name = meta.name.empty() ? "Effect Controls" : (meta.name + " Controls");
+	obs_properties_add_group(props, "shader_options", group_name.c_str(), OBS_GROUP_NORMAL, shader_opts);
+}
+
+void shader_effect_defaults(obs_data_t *settings, const char *default_module_file)
+{
+	char *default_effect = obs_module_file(default_module_file);
+	if (default_effect) {
+		obs_data_set_default_string(settings, S_EFFECT_PATH, default_effect);
+		bfree(default_effect);
+	}
+
+	obs_data_set_default_int(settings, "color1", 0xFFFFFF);
+	obs_data_set_default_int(settings, "color2", 0xFFD200);
+	obs_data_set_default_int(settings, "color3", 0xBB509D);
+	obs_data_set_default_int(settings, "color4", 0xAC3CFF);
+	obs_data_set_default_int(settings, S_QUALITY_TIER, 0);
+}
+
+obs_property_t *shader_effect_add_path_property(obs_properties_t *props, obs_property_modified_t modified)
+{
+	obs_property_t *effect_path = obs_properties_add_path(props, S_EFFECT_PATH, "HLSL / OBS .effect file",
+							      OBS_PATH_FILE, "OBS Effect (*.effect);;All files (*.*)",
+							      nullptr);
+	if (modified)
+		obs_property_set_modified_callback(effect_path, modified);
+	return effect_path;
+}
+
+const char *shader_effect_settings_path(obs_data_t *settings)
+{
+	return obs_data_get_string(settings, S_EFFECT_PATH);
+}
+
+bool shader_effect_update_settings(shader_effect *s, obs_data_t *settings)
+{
+	if (!s)
+		return false;
+
+	for (int i = 1; i <= 8; ++i) {
+		char key[32];
+		snprintf(key, sizeof(key), "%s%d", S_OPTION_PREFIX, i);
+		s->options[(size_t)i - 1] = float(obs_data_get_double(settings, key));
+	}
+	for (int i = 1; i <= 4; ++i) {
+		char key[32];
+		snprintf(key, sizeof(key), "%s%d", S_COLOR_PREFIX, i);
+		s->colors[(size_t)i - 1] = uint32_t(obs_data_get_int(settings, key)) & 0xFFFFFFu;
+	}
+	s->quality_setting = std::clamp<int>((int)obs_data_get_int(settings, S_QUALITY_TIER), 0, kMaxQualityTiers);
+
+	const char *new_effect = obs_data_get_string(settings, S_EFFECT_PATH);
+	std::string next_path = new_effect ? new_effect : "";
+	if (next_path == s->effect_path)
+		return false;
+
+	s->effect_path = next_path;
+	s->reload_effect = true;
+	s->quality_tier = 0;
+	return true;
+}
+
+void shader_effect_request_recompile(shader_effect *s)
+{
+	if (!s)
+		return;
+
+	s->reload_effect = true;
+	s->recompile = true;
+	s->effect_error.clear();
+}
+
+static void release_effect(shader_effect *s)
+{
+	effect_registry_release(s->entry);
+	s->entry = nullptr;
+	s->effect = nullptr;
+	s->samples_image = false;
+	s->quality_pending = 0;
+}
+
+static void hold_effect(shader_effect *s, effect_entry *entry)
+{
+	s->entry = entry;
+	s->effect = entry ? entry->effect : nullptr;
+	s->samples_image = entry && entry->samples_image;
+}
+
+// Define-mode tiers are separate compiles with QUALITY set to the tier and
+// QUALITY_<tier> defined, since the effect preprocessor only has #ifdef.
+static std::string tier_variant(int quality_tiers, bool quality_uniform, int tier)
+{
+	if (quality_tiers <= 1 || quality_uniform)
+		return std::string();
+	char variant[64];
+	snprintf(variant, sizeof(variant), "#define QUALITY %d\n#define QUALITY_%d\n", tier, tier);
+	return variant;
+}
+
+static std::string tier_variant(const shader_effect *s, int tier)
+{
+	return tier_variant(s->quality_tiers, s->quality_uniform, tier);
+}
+
+static int fixed_tier(const shader_effect *s)
+{
+	return s->quality_setting > 0 ? std::min(s->quality_setting, s->quality_tiers) : s->quality_tiers;
+}
+
+void shader_effect_preload_bundled()
+{
+	const std::string dir_path = shader_effect_module_path("effects");
+	os_dir_t *dir = dir_path.empty() ? nullptr : os_opendir(dir_path.c_str());
+	if (!dir) {
+		BLOG(LOG_WARNING, "Bundled effects folder not found; nothing to preload");
+		return;
+	}
+
+	std::vector<std::string> paths;
+	for (os_dirent *ent = os_readdir(dir); ent; ent = os_readdir(dir)) {
+		const char *ext = ent->directory ? nullptr : os_get_path_extension(ent->d_name);
+		if (ext && strcmp(ext, ".effect") == 0)
+			paths.push_back(dir_path + "/" + ent->d_name);
+	}
+	os_closedir(dir);
+	std::sort(paths.begin(), paths.end());
+
+	// The variant a new instance loads first goes ahead for every effect;
+	// the lower define-mode tiers, which only large canvases and the render
+	// governor switch to, follow after all of them.
+	std::vector<std::pair<std::string, std::string>> lower_tiers;
+	for (const std::string &path : paths) {
+		const effect_metadata meta = load_effect_metadata(path);
+		effect_registry_preload(path, tier_variant(meta.quality_tiers, meta.quality_uniform, meta.quality_tiers));
+		if (meta.quality_uniform)
+			continue;
+		for (int tier = meta.quality_tiers - 1; tier >= 1; --tier)
+			lower_tiers.emplace_back(path, tier_variant(meta.quality_tiers, false, tier));
+	}
+	for (const auto &[path, variant] : lower_tiers)
+		effect_registry_preload(path, variant);
+
+	BLOG(LOG_INFO, "Preloading %zu bundled effects (%zu extra quality tiers) in the background", paths.size(),
+	     lower_tiers.size());
+}
+
+void shader_effect_load_if_needed(shader_effect *s)
+{
+	if (!s)
+		return;
+
+	// Another user of the same effect recompiled it; move to the new copy.
+	if (s->entry && s->entry->superseded)
+		s->reload_effect = true;
+	if (!s->reload_effect)
+		return;
+
+	s->reload_effect = false;
+	release_effect(s);
+	s->effect_error.clear();
+
+	if (s->effect_path.empty()) {
+		BLOG(LOG_WARNING, "No .effect file selected");
+		return;
+	}
+
+	if (s->recompile) {
+		effect_registry_invalidate(s->effect_path);
+		s->recompile = false;
+	}
+
+	const effect_metadata meta = load_effect_metadata(s->effect_path);
+	s->quality_tiers = meta.quality_tiers;
+	s->quality_uniform = meta.quality_uniform;
+	if (s->quality_tier < 1 || s->quality_tier > s->quality_tiers)
+		s->quality_tier = fixed_tier(s);
+
+	hold_effect(s, effect_registry_acquire(s->effect_path, tier_variant(s, s->quality_tier), s->effect_error));
+}
+
+int shader_effect_auto_tier(const shader_effect *s, uint32_t width, uint32_t height)
+{
+	if (!s || s->quality_tiers <= 1 || s->quality_setting > 0)
+		return 0;
+
+	const uint64_t pixels = uint64_t(width) * uint64_t(height);
+	int tier = s->quality_tiers;
+	for (uint64_t threshold : kTierPixelThresholds) {
+		if (pixels > threshold)
+			--tier;
+	}
+	return std::max(1, tier);
+}
+
+void shader_effect_select_tier(shader_effect *s, int tier)
+{
+	if (!s || !s->entry || s->quality_tiers <= 1)
+		return;
+
+	tier = std::clamp(tier > 0 ? tier : fixed_tier(s), 1, s->quality_tiers);
+	if (tier == s->quality_tier)
+		return;
+
+	if (!s->quality_uniform) {
+		// Keep drawing the current tier until the new variant is ready.
+		const std::string variant = tier_variant(s, tier);
+		effect_entry *next = effect_registry_try_acquire(s->effect_path, variant);
+		if (!next) {
+			if (s->quality_pending != tier) {
+				effect_registry_compile_async(s->effect_path, variant);
+				s->quality_pending = tier;
+			}
+			return;
+		}
+		effect_registry_release(s->entry);
+		hold_effect(s, next);
+		s->quality_pending = 0;
+	}
+
+	BLOG(LOG_INFO, "Effect '%s' switched to quality tier %d of %d", s->effect_path.c_str(), tier,
+	     s->quality_tiers);
+	s->quality_tier = tier;
+}
+
+const char *shader_effect_technique_name(const shader_effect *s)
+{
+	if (!s || !s->effect)
+		return nullptr;
+
+	static const char *names[] = {"Draw", "Solid", "Default"};
+	for (const char *name : names) {
+		if (gs_effect_get_technique(s->effect, name))
+			return name;
+	}
+	return nullptr;
+}
+
+gs_technique_t *shader_effect_technique(const shader_effect *s)
+{
+	const char *name = shader_effect_technique_name(s);
+	return name ? gs_effect_get_technique(s->effect, name) : nullptr;
+}
+
+static void set_float_param(gs_eparam_t *p, float value)
+{
+	if (p)
+		gs_effect_set_float(p, value);
+}
+
+static void set_vec2_param(gs_eparam_t *p, float x, float y)
+{
+	if (p) {
+		vec2 v;
+		vec2_set(&v, x, y);
+		gs_effect_set_vec2(p, &v);
+	}
+}
+
+static void set_color_param(gs_eparam_t *p, uint32_t color)
+{
+	if (p) {
+		vec4 v;
+		color_to_vec4(color, &v);
+		gs_effect_set_vec4(p, &v);
+	}
+}
+
+void shader_effect_update_band_texture(shader_effect *s, const audio_analyzer &a, obs_source_t *owner)
+{
+	if (!s)
+		return;
+
+	AW_TRACE_SCOPE("band_upload");
+	const uint64_t probe_t0 = AW_PROBE_CLOCK(update_band_texture_exit);
+	AW_PROBE2(update_band_texture_entry, aw_probe_id(owner), a.band_count);
+
+	for (size_t i = 0; i < a.bands.size(); ++i) {
+		const size_t px = i * 4;
+		s->band_texture_pixels[px + 0] = uint8_t(clamp01(a.bands[i]) * 255.0f + 0.5f);
+		s->band_texture_pixels[px + 1] = uint8_t(clamp01(a.bass) * 255.0f + 0.5f);
+		s->band_texture_pixels[px + 2] = uint8_t(clamp01(a.mid) * 255.0f + 0.5f);
+		s->band_texture_pixels[px + 3] = uint8_t(clamp01(a.treble) * 255.0f + 0.5f);
+	}
+
+	if (!s->band_texture) {
+		const uint8_t *data[] = {s->band_texture_pixels.data()};
+		s->band_texture = gs_texture_create(64, 1, GS_RGBA, 1, data, GS_DYNAMIC);
+		if (!s->band_texture) {
+			BLOG(LOG_ERROR, "Failed to create FFT band texture for source '%s'",
+			     obs_source_get_name(owner));
+		}
+	} else {
+		gs_texture_set_image(s->band_texture, s->band_texture_pixels.data(), 64 * 4, false);
+	}
+
+	AW_PROBE2(update_band_texture_exit, aw_probe_id(owner), aw_probe_elapsed(probe_t0));
+}
+
+static void set_texture_param(gs_eparam_t *p, gs_texture_t *texture)
+{
+	if (p)
+		gs_effect_set_texture(p, texture);
+}
+
+// The compiled effect is shared with every other user of the same file, so
+// every parameter is written on each draw, including null textures and the
+// zero padding of array uniforms; nothing from another instance's draw may
+// survive into this one.
+void shader_effect_set_params(shader_effect *s, const audio_analyzer &a, uint32_t width, uint32_t height)
+{
+	if (!s->entry)
+		return;
+	const effect_params &p = s->entry->params;
+
+	set_vec2_param(p.source_size, float(width), float(height));
+	set_vec2_param(p.resolution, float(width), float(height));
+	set_float_param(p.time, float(os_gettime_ns() / 1000000000.0));
+	set_float_param(p.audio_level, a.level);
+	set_float_param(p.audio_peak, a.peak);
+	set_float_param(p.audio_bass, a.bass);
+	set_float_param(p.audio_mid, a.mid);
+	set_float_param(p.audio_treble, a.treble);
+	set_float_param(p.audio_section_change, a.section_change);
+	set_float_param(p.audio_energy_trend, a.energy_trend);
+	set_float_param(p.band_count, float(a.band_count));
+	set_float_param(p.quality, float(s->quality_tier));
+
+	set_texture_param(p.band_texture, s->band_texture);
+	set_texture_param(p.spectrum_texture, s->band_texture);
+
+	// Array uniforms go up in one call each, zero-padded to the declared
+	// length.
+	std::array<float, 256 * 4> scratch{};
+	if (p.bands) {
+		std::copy_n(a.bands.begin(), std::min(p.bands_len, a.bands.size()), scratch.begin());
+		gs_effect_set_val(p.bands, scratch.data(), sizeof(float) * p.bands_len);
+	}
+	if (p.bands4) {
+		scratch.fill(0.0f);
+		std::copy_n(a.bands.begin(), std::min(p.bands4_len * 4, a.bands.size()), scratch.begin());
+		gs_effect_set_val(p.bands4, scratch.data(), sizeof(float) * 4 * p.bands4_len);
+	}
+	if (p.features) {
+		scratch.fill(0.0f);
+		const float features[] = {a.level,  a.peak,          a.bass,          a.mid,
+					  a.treble, float(a.band_count), a.section_change, a.energy_trend};
+		std::copy_n(features, std::min(p.features_len * 4, std::size(features)), scratch.begin());
+		gs_effect_set_val(p.features, scratch.data(), sizeof(float) * 4 * p.features_len);
+	}
+
+	for (size_t i = 0; i < s->options.size(); ++i)
+		set_float_param(p.options[i], s->options[i]);
+	for (size_t i = 0; i < s->colors.size(); ++i)
+		set_color_param(p.colors[i], s->colors[i]);
+}
+
+void shader_effect_destroy(shader_effect *s)
+{
+	if (!s)
+		return;
+
+	release_effect(s);
+	if (s->band_texture) {
+		gs_texture_destroy(s->band_texture);
+		s->band_texture = nullptr;
+	}
+}
@@ -0,0 +1,150 @@
+#include "includes/song-structure.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Energy differences count double: a drop is mostly a jump in loudness.
+static constexpr float kEnergyWeight = 2.0f;
+// Novelty must clear both this floor and the adaptive threshold.
+static constexpr float kMinNovelty = 0.015f;
+static constexpr float kThresholdDevs = 3.0f;
+// Per-frame weight of the threshold averages, roughly a 20 second memory.
+static constexpr float kThresholdRate = 1.0f / 80.0f;
+// Boundaries closer than this are treated as the same change.
+static constexpr uint64_t kRefractoryNs = 4000000000ull;
+static constexpr float kChangeDecaySec = 1.5f;
+static constexpr float kTrendSmoothSec = 0.5f;
+static constexpr float kTrendGain = 4.0f;
+
+static float frame_distance(const song_frame &a, const song_frame &b)
+{
+	float d = 0.0f;
+	for (int i = 0; i < kSongDims; ++i)
+		d += std::fabs(a.timbre[(size_t)i] - b.timbre[(size_t)i]);
+	d += std::fabs(a.energy - b.energy) * kEnergyWeight;
+	return d / (float(kSongDims) + kEnergyWeight);
+}
+
+// Checkerboard kernel over the self-similarity of the history: the mean
+// distance between the older and recent sides minus the mean distance within
+// each side. Each frame pair is visited once.
+static float history_novelty(const song_structure *s)
+{
+	const song_frame *f[kSongFrames];
+	for (int i = 0; i < kSongFrames; ++i)
+		f[i] = &s->frames[(size_t)((s->pos + i) % kSongFrames)];
+
+	const int split = kSongFrames - kSongRecentFrames;
+	float cross = 0.0f;
+	float older = 0.0f;
+	float recent = 0.0f;
+	for (int i = 0; i < kSongFrames; ++i) {
+		for (int j = i + 1; j < kSongFrames; ++j) {
+			const float d = frame_distance(*f[i], *f[j]);
+			if (j < split)
+				older += d;
+			else if (i >= split)
+				recent += d;
+			else
+				cross += d;
+		}
+	}
+
+	cross /= float(split * kSongRecentFrames);
+	older /= float(split * (split - 1) / 2);
+	recent /= float(kSongRecentFrames * (kSongRecentFrames - 1) / 2);
+	return std::max(0.0f, cross - (older + recent) * 0.5f);
+}
+
+// Energy of the newer half of the history against the older half.
+static float history_trend(const song_structure *s)
+{
+	float older = 0.0f;
+	float newer = 0.0f;
+	for (int i = 0; i < kSongFrames; ++i) {
+		const float e = s->frames[(size_t)((s->pos + i) % kSongFrames)].energy;
+		if (i < kSongFrames / 2)
+			older += e;
+		else
+			newer += e;
+	}
+	return std::clamp((newer - older) / float(kSongFrames / 2) * kTrendGain, -1.0f, 1.0f);
+}
+
+static void push_frame(song_structure *s, uint64_t now_ns)
+{
+	song_frame &frame = s->frames[(size_t)s->pos];
+	const float inv = 1.0f / float(s->accum_n);
+	for (int i = 0; i < kSongDims; ++i)
+		frame.timbre[(size_t)i] = s->accum.timbre[(size_t)i] * inv;
+	frame.energy = s->accum.energy * inv;
+
+	s->pos = (s->pos + 1) % kSongFrames;
+	s->count = std::min(s->count + 1, kSongFrames);
+	s->accum = song_frame{};
+	s->accum_n = 0;
+
+	if (s->count < kSongFrames)
+		return;
+
+	const float novelty = history_novelty(s);
+	s->novelty = novelty;
+	s->trend_target = history_trend(s);
+
+	const float threshold = std::max(kMinNovelty, s->novelty_mean + s->novelty_dev * kThresholdDevs);
+	const bool rested = s->last_change_ns == 0 || now_ns - s->last_change_ns >= kRefractoryNs;
+	if (novelty > threshold && rested) {
+		s->section_change = 1.0f;
+		s->last_change_ns = now_ns;
+	}
+
+	// The threshold follows the track, so a busy passage does not fire on
+	// every small variation and a quiet one still registers its changes.
+	s->novelty_dev += (std::fabs(novelty - s->novelty_mean) - s->novelty_dev) * kThresholdRate;
+	s->novelty_mean += (novelty - s->novelty_mean) * kThresholdRate;
+}
+
+static void relax_outputs(song_structure *s, float dt)
+{
+	s->section_change *= std::exp(-dt / kChangeDecaySec);
+	s->energy_trend += (s->trend_target - s->energy_trend) * (1.0f - std::exp(-dt / kTrendSmoothSec));
+}
+
+void song_structure_update(song_structure *s, const float *raw_bands, int band_count, float energy, uint64_t now_ns,
+			   float dt)
+{
+	if (band_count <= 0)
+		return;
+
+	// Fold however many bands the governor left into kSongDims groups.
+	for (int d = 0; d < kSongDims; ++d) {
+		const int b0 = d * band_count / kSongDims;
+		const int b1 = std::max(b0 + 1, (d + 1) * band_count / kSongDims);
+		float sum = 0.0f;
+		for (int b = b0; b < b1 && b < band_count; ++b)
+			sum += raw_bands[b];
+		s->accum.timbre[(size_t)d] += sum / float(b1 - b0);
+	}
+	s->accum.energy += energy;
+	++s->accum_n;
+
+	// Starting phase_ns early makes the first frame shorter, which shifts
+	// every later boundary by the same amount.
+	const uint64_t phased_now = now_ns > s->phase_ns ? now_ns - s->phase_ns : now_ns;
+	if (s->frame_start_ns == 0 || now_ns < s->frame_start_ns)
+		s->frame_start_ns = phased_now;
+	if (now_ns - s->frame_start_ns >= kSongFrameNs) {
+		push_frame(s, now_ns);
+		// After a long stall start a fresh frame instead of catching up.
+		s->frame_start_ns = now_ns - s->frame_start_ns >= kSongFrameNs * 2 ? phased_now
+										    : s->frame_start_ns + kSongFrameNs;
+	}
+
+	relax_outputs(s, dt);
+}
+
+void song_structure_idle(song_structure *s, float dt)
+{
+	s->trend_target = 0.0f;
+	relax_outputs(s, dt);
+}
@@ -0,0 +1,213 @@
+#include "includes/thread-priority.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// SCHED_FIFO priority for "realtime" workers: above every normal thread but
+// well below the audio server threads that typically sit at 20 and up.
+static constexpr int kRealtimeFifoPriority = 10;
+static constexpr int kHighNice = -10;
+
+thread_priority_level thread_priority_parse(const char *text)
+{
+	if (!text)
+		return THREAD_PRIORITY_LEVEL_NORMAL;
+	if (strcmp(text, "realtime") == 0)
+		return THREAD_PRIORITY_LEVEL_REALTIME;
+	if (strcmp(text, "high") == 0)
+		return THREAD_PRIORITY_LEVEL_HIGH;
+	return THREAD_PRIORITY_LEVEL_NORMAL;
+}
+
+const char *thread_priority_name(thread_priority_level level)
+{
+	switch (level) {
+	case THREAD_PRIORITY_LEVEL_REALTIME:
+		return "realtime";
+	case THREAD_PRIORITY_LEVEL_HIGH:
+		return "high";
+	default:
+		return "normal";
+	}
+}
+
+std::vector<int> thread_affinity_parse(const char *text)
+{
+	std::vector<int> cpus;
+	if (!text)
+		return cpus;
+
+	const char *p = text;
+	while (*p) {
+		char *end = nullptr;
+		const long first = strtol(p, &end, 10);
+		if (end == p) {
+			++p;
+			continue;
+		}
+		long last = first;
+		p = end;
+		if (*p == '-') {
+			const long parsed = strtol(p + 1, &end, 10);
+			if (end != p + 1) {
+				last = parsed;
+				p = end;
+			}
+		}
+		for (long cpu = first; cpu <= last && cpu < 1024; ++cpu) {
+			if (cpu >= 0)
+				cpus.push_back((int)cpu);
+		}
+		while (*p == ',' || *p == ' ')
+			++p;
+	}
+	return cpus;
+}
+
+static std::string cpu_list_text(const std::vector<int> &cpus)
+{
+	std::string text;
+	for (int cpu : cpus) {
+		if (!text.empty())
+			text += ",";
+		text += std::to_string(cpu);
+	}
+	return text;
+}
+
+#if defined(_WIN32)
+
+static std::string apply_priority(thread_priority_level level)
+{
+	if (level == THREAD_PRIORITY_LEVEL_NORMAL)
+		return "priority normal";
+
+	const int value = level == THREAD_PRIORITY_LEVEL_REALTIME ? THREAD_PRIORITY_TIME_CRITICAL
+								   : THREAD_PRIORITY_ABOVE_NORMAL;
+	if (SetThreadPriority(GetCurrentThread(), value))
+		return std::string("priority ") + thread_priority_name(level);
+	return "priority normal (SetThreadPriority failed, error " + std::to_string(GetLastError()) + ")";
+}
+
+static std::string apply_affinity(const std::vector<int> &cpus)
+{
+	DWORD_PTR mask = 0;
+	for (int cpu : cpus) {
+		if (cpu < int(sizeof(DWORD_PTR) * 8))
+			mask |= DWORD_PTR(1) << cpu;
+	}
+	if (!mask)
+		return "affinity unchanged (no usable CPUs listed)";
+	if (SetThreadAffinityMask(GetCurrentThread(), mask))
+		return "affinity " + cpu_list_text(cpus);
+	return "affinity unchanged (SetThreadAffinityMask failed, error " + std::to_string(GetLastError()) + ")";
+}
+
+#elif defined(__APPLE__)
+
+static std::string apply_priority(thread_priority_level level)
+{
+	if (level == THREAD_PRIORITY_LEVEL_NORMAL)
+		return "priority normal";
+
+	// macOS has no unprivileged fixed-priority class; QoS is the closest.
+	const qos_class_t qos =
+		level == THREAD_PRIORITY_LEVEL_REALTIME ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED;
+	const int err = pthread_set_qos_class_self_np(qos, 0);
+	if (err == 0)
+		return std::string("priority ") + thread_priority_name(level) + " (QoS class)";
+	return std::string("priority normal (QoS request failed: ") + strerror(err) + ")";
+}
+
+static std::string apply_affinity(const std::vector<int> &)
+{
+	return "affinity unchanged (not supported on macOS)";
+}
+
+#elif defined(__linux__)
+
+static std::string apply_nice(int nice_value)
+{
+	const id_t tid = (id_t)syscall(SYS_gettid);
+	if (setpriority(PRIO_PROCESS, tid, nice_value) == 0)
+		return "nice " + std::to_string(nice_value);
+	return std::string("normal (nice ") + std::to_string(nice_value) + " refused: " + strerror(errno) + ")";
+}
+
+static std::string apply_priority(thread_priority_level level)
+{
+	if (level == THREAD_PRIORITY_LEVEL_NORMAL)
+		return "priority normal";
+
+	if (level == THREAD_PRIORITY_LEVEL_REALTIME) {
+		sched_param param = {};
+		param.sched_priority = kRealtimeFifoPriority;
+		const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (err == 0)
+			return "priority realtime (SCHED_FIFO " + std::to_string(kRealtimeFifoPriority) + ")";
+		return std::string("priority ") + apply_nice(kHighNice) + " after SCHED_FIFO was refused: " +
+		       strerror(err);
+	}
+
+	return "priority " + apply_nice(kHighNice);
+}
+
+static std::string apply_affinity(const std::vector<int> &cpus)
+{
+	const long online = sysconf(_SC_NPROCESSORS_ONLN);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	std::vector<int> used;
+	for (int cpu : cpus) {
+		if (cpu < CPU_SETSIZE && (online <= 0 || cpu < online)) {
+			CPU_SET(cpu, &set);
+			used.push_back(cpu);
+		}
+	}
+	if (used.empty())
+		return "affinity unchanged (no usable CPUs listed)";
+
+	const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (err == 0)
+		return "affinity " + cpu_list_text(used);
+	return std::string("affinity unchanged (") + strerror(err) + ")";
+}
+
+#else
+
+// Other POSIX systems (the BSDs) have neither gettid nor cpu_set_t.
+static std::string apply_priority(thread_priority_level level)
+{
+	if (level == THREAD_PRIORITY_LEVEL_NORMAL)
+		return "priority normal";
+	return "priority normal (unsupported on this platform)";
+}
+
+static std::string apply_affinity(const std::vector<int> &)
+{
+	return "affinity unchanged (unsupported on this platform)";
+}
+
+#endif
+
+std::string thread_tuning_apply_current(const thread_tuning &tuning)
+{
+	std::string report = apply_priority(tuning.priority);
+	report += ", ";
+	report += tuning.cpus.empty() ? std::string("affinity unchanged") : apply_affinity(tuning.cpus);
+	return report;
+}
@@ -0,0 +1,329 @@
+// Golden-data test for the analysis path. Each WAV fixture is pushed through
+// audio_analyzer_push_audio() in OBS-sized packets on a fixed simulated clock,
+// the analyzer is ticked at 60 fps, and every output is compared frame by
+// frame against the CSV committed under golden/.
+//
+//   aw-analysis-golden-test <fixtures-dir> <golden-dir>            compare
+//   aw-analysis-golden-test --update <fixtures-dir> <golden-dir>   rewrite the goldens
+//   aw-analysis-golden-test --write-fixtures <fixtures-dir>        re-synthesise the WAVs
+//
+// The per-cell band layout is a hash-driven shuffle of the strongest bands,
+// so bands are pinned by their mean and maximum rather than cell by cell.
+
+#include "includes/audio-analyzer.hpp"
+#include "obs-stub.hpp"
+#include "wav.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static constexpr size_t kAudioPacketFrames = 1024;
+static constexpr double kVideoFps = 60.0;
+// The clock starts away from zero; 0 means "no previous tick" to the analyzer.
+static constexpr uint64_t kClockStartNs = 1000000000ull;
+static constexpr double kFixtureSec = 1.0;
+static constexpr int kFixtureRate = 48000;
+
+enum golden_column {
+	COL_LEVEL,
+	COL_PEAK,
+	COL_BASS,
+	COL_MID,
+	COL_TREBLE,
+	COL_SECTION_CHANGE,
+	COL_ENERGY_TREND,
+	COL_BANDS_MEAN,
+	COL_BANDS_MAX,
+	COL_COUNT,
+};
+
+static const char *kColumnNames[COL_COUNT] = {"level",         "peak",         "bass",
+					      "mid",           "treble",       "section_change",
+					      "energy_trend",  "bands_mean",   "bands_max"};
+
+// Absolute tolerance per column. The smoothed outputs only drift by libm
+// rounding; the band cells also move with the peak picking.
+static const float kTolerance[COL_COUNT] = {2e-3f, 2e-3f, 2e-3f, 2e-3f, 2e-3f, 2e-3f, 2e-3f, 1e-2f, 2e-2f};
+
+struct golden_fixture {
+	const char *name;
+	bool float_format;
+	float (*sample)(size_t i, double rate, std::mt19937 &rng);
+};
+
+static constexpr double kPi = 3.14159265358979323846;
+
+// Logarithmic sweep from 40 Hz to 16 kHz.
+static float sweep_sample(size_t i, double rate, std::mt19937 &)
+{
+	const double t = double(i) / rate;
+	const double f0 = 40.0;
+	const double k = std::log(16000.0 / f0) / kFixtureSec;
+	return float(0.5 * std::sin(2.0 * kPi * f0 * (std::exp(k * t) - 1.0) / k));
+}
+
+// 220 Hz for the first half, then 3 kHz, so the bass-to-treble hand-off is
+// pinned as well as the steady states.
+static float tones_sample(size_t i, double rate, std::mt19937 &)
+{
+	const double t = double(i) / rate;
+	const double f = t < kFixtureSec * 0.5 ? 220.0 : 3000.0;
+	return float(0.4 * std::sin(2.0 * kPi * f * t));
+}
+
+// 150 bpm: kick on every beat, snare on the off-beats, closed hats on
+// eighths.
+static float drums_sample(size_t i, double rate, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	const double t = double(i) / rate;
+	const double beat = 60.0 / 150.0;
+	const double in_beat = std::fmod(t, beat);
+	const double in_eighth = std::fmod(t, beat * 0.5);
+	const bool off_beat = std::fmod(t, beat * 2.0) >= beat;
+
+	double v = 0.0;
+	// Kick: a pitch drop from 120 to 50 Hz under a fast decay.
+	const double kick_f = 50.0 + 70.0 * std::exp(-in_beat * 30.0);
+	v += 0.8 * std::exp(-in_beat * 12.0) * std::sin(2.0 * kPi * kick_f * in_beat);
+	if (off_beat)
+		v += 0.35 * std::exp(-in_beat * 20.0) * noise(rng);
+	v += 0.12 * std::exp(-in_eighth * 80.0) * noise(rng);
+	return float(v);
+}
+
+static float silence_sample(size_t, double, std::mt19937 &)
+{
+	return 0.0f;
+}
+
+// 100 Hz driven well past full scale: a flat-topped square with overshoots
+// beyond the analyzer's own sample clamp, stored as float so nothing is
+// lost on the way in.
+static float clipping_sample(size_t i, double rate, std::mt19937 &)
+{
+	const double t = double(i) / rate;
+	const double v = 4.0 * std::sin(2.0 * kPi * 100.0 * t);
+	if (i % 4800 == 0)
+		return 24.0f;
+	return float(std::clamp(v, -1.5, 1.5));
+}
+
+static const golden_fixture kFixtures[] = {
+	{"sweep", false, sweep_sample},   {"tones", false, tones_sample},       {"drums", false, drums_sample},
+	{"silence", false, silence_sample}, {"clipping", true, clipping_sample},
+};
+
+using golden_row = std::vector<float>;
+
+static bool write_fixtures(const std::string &dir)
+{
+	for (const golden_fixture &fx : kFixtures) {
+		std::mt19937 rng(1234);
+		wav_audio audio;
+		audio.sample_rate = kFixtureRate;
+		audio.channels = 1;
+		audio.samples.resize(size_t(kFixtureSec * kFixtureRate));
+		for (size_t i = 0; i < audio.samples.size(); ++i)
+			audio.samples[i] = fx.sample(i, double(kFixtureRate), rng);
+
+		const std::string path = dir + "/" + fx.name + ".wav";
+		if (!wav_write(path, audio, fx.float_format)) {
+			fprintf(stderr, "could not write %s\n", path.c_str());
+			return false;
+		}
+		printf("wrote %s\n", path.c_str());
+	}
+	return true;
+}
+
+// Runs one fixture through a fresh analyzer with default settings and the
+// governor off, returning one row per video frame.
+static std::vector<golden_row> run_fixture(const wav_audio &audio)
+{
+	auto a = std::make_unique<audio_analyzer>();
+	audio_analyzer_init(a.get(), nullptr);
+
+	obs_data_t *settings = obs_data_create();
+	audio_analyzer_defaults(settings);
+	obs_data_set_double(settings, "cpu_budget_ms", 0.0);
+	audio_analyzer_update_settings(a.get(), settings);
+	obs_data_release(settings);
+	a->sample_rate = audio.sample_rate;
+
+	// De-interleave into planar left/right like an OBS audio packet.
+	const size_t frames = audio.frames();
+	const size_t ch = (size_t)audio.channels;
+	std::vector<float> left(kAudioPacketFrames);
+	std::vector<float> right(kAudioPacketFrames);
+
+	const double packet_sec = double(kAudioPacketFrames) / double(audio.sample_rate);
+	const double frame_sec = 1.0 / kVideoFps;
+	const double total_sec = double(frames) / double(audio.sample_rate);
+	size_t next_sample = 0;
+	double next_packet = packet_sec;
+	double next_frame = frame_sec;
+
+	std::vector<golden_row> rows;
+	while (next_frame <= total_sec) {
+		// A packet is delivered once its last sample has been captured.
+		if (next_packet <= next_frame && next_sample + kAudioPacketFrames <= frames) {
+			for (size_t i = 0; i < kAudioPacketFrames; ++i) {
+				const float *in = &audio.samples[(next_sample + i) * ch];
+				left[i] = in[0];
+				right[i] = ch > 1 ? in[1] : in[0];
+			}
+			audio_analyzer_push_audio(a.get(), left.data(), right.data(), kAudioPacketFrames, false);
+			next_sample += kAudioPacketFrames;
+			next_packet += packet_sec;
+			continue;
+		}
+
+		audio_analyzer_tick(a.get(), kClockStartNs + uint64_t(next_frame * 1000000000.0));
+		float sum = 0.0f;
+		float max = 0.0f;
+		for (float band : a->bands) {
+			sum += band;
+			max = std::max(max, band);
+		}
+		rows.push_back({a->level, a->peak, a->bass, a->mid, a->treble, a->section_change, a->energy_trend,
+				sum / float(a->bands.size()), max});
+		next_frame += frame_sec;
+	}
+
+	audio_analyzer_shutdown(a.get());
+	return rows;
+}
+
+static bool write_golden(const std::string &path, const std::vector<golden_row> &rows)
+{
+	FILE *file = fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+	fprintf(file, "frame");
+	for (const char *name : kColumnNames)
+		fprintf(file, ",%s", name);
+	fprintf(file, "\n");
+	for (size_t f = 0; f < rows.size(); ++f) {
+		fprintf(file, "%zu", f);
+		for (float v : rows[f])
+			fprintf(file, ",%.6f", double(v));
+		fprintf(file, "\n");
+	}
+	const bool ok = fflush(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+static bool read_golden(const std::string &path, std::vector<golden_row> &rows)
+{
+	std::ifstream in(path);
+	if (!in)
+		return false;
+	std::string line;
+	std::getline(in, line);
+	while (std::getline(in, line)) {
+		std::istringstream cells(line);
+		std::string cell;
+		std::getline(cells, cell, ',');
+		golden_row row;
+		while (std::getline(cells, cell, ','))
+			row.push_back(std::strtof(cell.c_str(), nullptr));
+		if (row.size() != COL_COUNT)
+			return false;
+		rows.push_back(row);
+	}
+	return true;
+}
+
+// Reports the worst frame per column; returns the number of failing columns.
+static int compare_rows(const char *name, const std::vector<golden_row> &got, const std::vector<golden_row> &want)
+{
+	if (got.size() != want.size()) {
+		fprintf(stderr, "%s: %zu frames, golden has %zu\n", name, got.size(), want.size());
+		return 1;
+	}
+
+	int failures = 0;
+	for (int c = 0; c < COL_COUNT; ++c) {
+		float worst = 0.0f;
+		size_t worst_frame = 0;
+		for (size_t f = 0; f < got.size(); ++f) {
+			const float diff = std::fabs(got[f][(size_t)c] - want[f][(size_t)c]);
+			if (!(diff <= worst)) {
+				worst = diff;
+				worst_frame = f;
+			}
+		}
+		if (!(worst <= kTolerance[c])) {
+			fprintf(stderr, "%s: %s off by %.6f at frame %zu (got %.6f, golden %.6f, tolerance %.6f)\n", name,
+				kColumnNames[c], double(worst), worst_frame, double(got[worst_frame][(size_t)c]),
+				double(want[worst_frame][(size_t)c]), double(kTolerance[c]));
+			++failures;
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<std::string> args(argv + 1, argv + argc);
+	const bool update = !args.empty() && args[0] == "--update";
+	const bool fixtures = !args.empty() && args[0] == "--write-fixtures";
+	if (update || fixtures)
+		args.erase(args.begin());
+
+	if (fixtures && args.size() == 1)
+		return write_fixtures(args[0]) ? 0 : 1;
+	if (fixtures || args.size() != 2) {
+		fprintf(stderr,
+			"usage: %s [--update] <fixtures-dir> <golden-dir>\n"
+			"       %s --write-fixtures <fixtures-dir>\n",
+			argv[0], argv[0]);
+		return 2;
+	}
+
+	int failures = 0;
+	for (const golden_fixture &fx : kFixtures) {
+		const std::string wav_path = args[0] + "/" + fx.name + ".wav";
+		const std::string golden_path = args[1] + "/" + fx.name + ".csv";
+
+		wav_audio audio;
+		std::string error;
+		if (!wav_read(wav_path, audio, error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			++failures;
+			continue;
+		}
+
+		const std::vector<golden_row> rows = run_fixture(audio);
+		if (update) {
+			if (!write_golden(golden_path, rows)) {
+				fprintf(stderr, "could not write %s\n", golden_path.c_str());
+				++failures;
+				continue;
+			}
+			printf("wrote %s (%zu frames)\n", golden_path.c_str(), rows.size());
+			continue;
+		}
+
+		std::vector<golden_row> want;
+		if (!read_golden(golden_path, want)) {
+			fprintf(stderr, "cannot read %s; run with --update to create it\n", golden_path.c_str());
+			++failures;
+			continue;
+		}
+		const int bad = compare_rows(fx.name, rows, want);
+		printf("%-10s %zu frames %s\n", fx.name, rows.size(), bad ? "FAILED" : "ok");
+		failures += bad;
+	}
+	return failures == 0 ? 0 : 1;
+}
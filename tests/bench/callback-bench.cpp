@@ -0,0 +1,81 @@
+// Cost of the audio capture path while another thread runs the analysis.
+// The audio thread's ingest state and the analysis/render state live in
+// separate cache-line-aligned blocks of audio_analyzer; this measures
+// audio_analyzer_push_audio() first with the analysis idle and then with a
+// thread ticking the same analyzer back to back, so false sharing between
+// the two shows up as a gap between the figures.
+//
+//   aw-callback-bench [packets]     default 200000
+
+#include "includes/audio-analyzer.hpp"
+#include "obs-stub.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// OBS delivers 10 ms packets at 48 kHz.
+static constexpr size_t kAudioPacketFrames = 480;
+
+static double push_ns_per_packet(audio_analyzer *a, const std::vector<float> &packet, int packets, bool concurrent,
+				 uint64_t &ticks_run)
+{
+	std::atomic<bool> stop{false};
+	std::atomic<uint64_t> ticks{0};
+	std::thread render([&] {
+		uint64_t now = 1000000000ull;
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (concurrent) {
+				now += 16666667ull;
+				audio_analyzer_tick(a, now);
+				ticks.fetch_add(1, std::memory_order_relaxed);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	const auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < packets; ++i)
+		audio_analyzer_push_audio(a, packet.data(), packet.data(), packet.size(), false);
+	const auto t1 = std::chrono::steady_clock::now();
+	stop.store(true);
+	render.join();
+
+	ticks_run = ticks.load();
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / packets;
+}
+
+int main(int argc, char **argv)
+{
+	const int packets = argc > 1 ? std::max(1, atoi(argv[1])) : 200000;
+	obs_stub_set_log_level(LOG_ERROR);
+
+	auto a = std::make_unique<audio_analyzer>();
+	audio_analyzer_init(a.get(), nullptr);
+	obs_data_t *settings = obs_data_create();
+	audio_analyzer_defaults(settings);
+	audio_analyzer_update_settings(a.get(), settings);
+	obs_data_release(settings);
+	// The governor would otherwise degrade the analysis under the load.
+	a->cpu_budget_ms = 0.0f;
+
+	std::vector<float> packet(kAudioPacketFrames);
+	for (size_t i = 0; i < packet.size(); ++i)
+		packet[i] = 0.3f * float(i % 50) / 50.0f;
+
+	uint64_t ticks = 0;
+	const double idle = push_ns_per_packet(a.get(), packet, packets, false, ticks);
+	printf("idle analysis:            %8.1f ns per %zu-frame packet\n", idle, kAudioPacketFrames);
+	const double busy = push_ns_per_packet(a.get(), packet, packets, true, ticks);
+	printf("with concurrent analysis: %8.1f ns per %zu-frame packet (%.2fx, %llu ticks alongside)\n", busy,
+	       kAudioPacketFrames, busy / idle, (unsigned long long)ticks);
+
+	audio_analyzer_shutdown(a.get());
+	return 0;
+}
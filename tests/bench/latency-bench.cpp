@@ -0,0 +1,250 @@
+// Offline latency measurement for the analysis path. Synthetic impulses and
+// tone bursts are pushed through audio_analyzer_push_audio() in OBS-sized
+// audio packets on a simulated clock, the analyzer is ticked at the video
+// frame rate, and for every FFT size and attack setting the time from the
+// stimulus onset until each output reaches half of its own peak and a fixed
+// visibility threshold is recorded.
+//
+//   aw-latency-bench [out.csv]      default latency.csv
+//
+// Writes the full table as CSV and prints a short digest per setting.
+
+#include "includes/audio-analyzer.hpp"
+#include "includes/config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <util/platform.h>
+
+// OBS hands audio to capture callbacks in packets of this many frames.
+static constexpr size_t kAudioPacketFrames = 1024;
+static constexpr double kVideoFps = 60.0;
+static constexpr double kWarmupSec = 1.0;
+static constexpr double kRunSec = 2.0;
+// Onset deliberately not aligned to audio packets or video frames.
+static constexpr double kOnsetSec = kWarmupSec + 0.0037;
+static constexpr double kResponseWindowSec = 0.5;
+// Outputs are 0..1; this is roughly where a response becomes obvious on screen.
+static constexpr float kVisibleThreshold = 0.3f;
+// Below this an output is treated as not responding at all.
+static constexpr float kMinResponse = 0.02f;
+
+static const int kFftSizes[] = {512, 1024, 2048, 4096, 8192};
+static const int kAttackMs[] = {0, 25, 100};
+
+enum latency_output {
+	OUTPUT_LEVEL,
+	OUTPUT_PEAK,
+	OUTPUT_BASS,
+	OUTPUT_MID,
+	OUTPUT_TREBLE,
+	OUTPUT_BANDS,
+	OUTPUT_COUNT,
+};
+
+static const char *kOutputNames[OUTPUT_COUNT] = {"level", "peak", "bass", "mid", "treble", "bands_max"};
+
+struct latency_stimulus {
+	const char *name;
+	double freq_hz;     // 0 for a single-sample impulse
+	double duration_ms; // burst length
+	float amplitude;
+};
+
+static const latency_stimulus kStimuli[] = {
+	{"impulse", 0.0, 0.0, 0.9f},
+	{"kick_80hz", 80.0, 120.0, 0.8f},
+	{"hat_12khz", 12000.0, 60.0, 0.5f},
+};
+
+static float stimulus_sample(const latency_stimulus &stim, size_t index, double sample_rate)
+{
+	const double rel = double(index) / sample_rate - kOnsetSec;
+	if (rel < 0.0)
+		return 0.0f;
+	if (stim.freq_hz <= 0.0)
+		return rel * sample_rate < 1.0 ? stim.amplitude : 0.0f;
+	if (rel * 1000.0 >= stim.duration_ms)
+		return 0.0f;
+	return stim.amplitude * float(std::sin(2.0 * 3.14159265358979323846 * stim.freq_hz * rel));
+}
+
+static float output_value(const audio_analyzer &a, int output)
+{
+	switch (output) {
+	case OUTPUT_LEVEL:
+		return a.level;
+	case OUTPUT_PEAK:
+		return a.peak;
+	case OUTPUT_BASS:
+		return a.bass;
+	case OUTPUT_MID:
+		return a.mid;
+	case OUTPUT_TREBLE:
+		return a.treble;
+	default:
+		return *std::max_element(a.bands.begin(), a.bands.end());
+	}
+}
+
+struct latency_trace {
+	std::vector<double> times;
+	std::vector<std::array<float, OUTPUT_COUNT>> values;
+};
+
+// Feeds one stimulus through a fresh analyzer and records every output at
+// each simulated video frame.
+static latency_trace run_stimulus(const latency_stimulus &stim, int fft_size, int attack_ms)
+{
+	auto a = std::make_unique<audio_analyzer>();
+	audio_analyzer_init(a.get(), nullptr);
+
+	obs_data_t *settings = obs_data_create();
+	audio_analyzer_defaults(settings);
+	audio_analyzer_update_settings(a.get(), settings);
+	obs_data_release(settings);
+
+	a->fft_size = fft_size;
+	a->ingest.ring_size = (size_t)fft_size;
+	a->attack_ms = float(attack_ms);
+	a->cpu_budget_ms = 0.0f;
+
+	const double sample_rate = double(a->sample_rate);
+	const double packet_sec = double(kAudioPacketFrames) / sample_rate;
+	const double frame_sec = 1.0 / kVideoFps;
+
+	std::vector<float> packet(kAudioPacketFrames);
+	size_t next_sample = 0;
+	double next_packet = packet_sec;
+	double next_frame = frame_sec;
+
+	latency_trace trace;
+	while (next_frame < kRunSec) {
+		// A packet is delivered once its last sample has been captured.
+		if (next_packet <= next_frame) {
+			for (size_t i = 0; i < kAudioPacketFrames; ++i)
+				packet[i] = stimulus_sample(stim, next_sample + i, sample_rate);
+			audio_analyzer_push_audio(a.get(), packet.data(), nullptr, kAudioPacketFrames, false);
+			next_sample += kAudioPacketFrames;
+			next_packet += packet_sec;
+			continue;
+		}
+
+		audio_analyzer_tick(a.get(), uint64_t(next_frame * 1000000000.0));
+		std::array<float, OUTPUT_COUNT> values{};
+		for (int o = 0; o < OUTPUT_COUNT; ++o)
+			values[(size_t)o] = output_value(*a, o);
+		trace.times.push_back(next_frame);
+		trace.values.push_back(values);
+		next_frame += frame_sec;
+	}
+
+	audio_analyzer_shutdown(a.get());
+	return trace;
+}
+
+struct latency_result {
+	float peak = 0.0f;
+	double half_rise_ms = -1.0; // onset to half of the output's own peak
+	double visible_ms = -1.0;   // onset to kVisibleThreshold
+};
+
+static latency_result measure_output(const latency_trace &trace, int output)
+{
+	latency_result r;
+	for (size_t i = 0; i < trace.times.size(); ++i) {
+		const double rel = trace.times[i] - kOnsetSec;
+		if (rel >= 0.0 && rel <= kResponseWindowSec)
+			r.peak = std::max(r.peak, trace.values[i][(size_t)output]);
+	}
+	if (r.peak < kMinResponse)
+		return r;
+
+	for (size_t i = 0; i < trace.times.size(); ++i) {
+		const double rel = trace.times[i] - kOnsetSec;
+		if (rel < 0.0 || rel > kResponseWindowSec)
+			continue;
+		const float v = trace.values[i][(size_t)output];
+		if (r.half_rise_ms < 0.0 && v >= r.peak * 0.5f)
+			r.half_rise_ms = rel * 1000.0;
+		if (r.visible_ms < 0.0 && v >= kVisibleThreshold)
+			r.visible_ms = rel * 1000.0;
+	}
+	return r;
+}
+
+static void write_ms(FILE *file, double ms)
+{
+	if (ms >= 0.0)
+		fprintf(file, ",%.1f", ms);
+	else
+		fprintf(file, ",");
+}
+
+// Runs the full sweep and writes it as CSV to path. summary receives one
+// digest line per setting. Returns false if the file could not be written.
+static bool write_latency_table(const char *path, std::string &summary)
+{
+	FILE *file = os_fopen(path, "wb");
+	if (!file)
+		return false;
+
+	fprintf(file, "version,fft_size,attack_ms,stimulus,output,peak,half_rise_ms,visible_ms\n");
+	summary.clear();
+
+	for (int fft_size : kFftSizes) {
+		for (int attack_ms : kAttackMs) {
+			char line[256];
+			snprintf(line, sizeof(line), "fft %d, attack %d ms:", fft_size, attack_ms);
+			std::string digest = line;
+
+			for (const latency_stimulus &stim : kStimuli) {
+				const latency_trace trace = run_stimulus(stim, fft_size, attack_ms);
+				for (int o = 0; o < OUTPUT_COUNT; ++o) {
+					const latency_result r = measure_output(trace, o);
+					fprintf(file, "%s,%d,%d,%s,%s,%.3f", PLUGIN_VERSION, fft_size, attack_ms, stim.name,
+						kOutputNames[o], r.peak);
+					write_ms(file, r.half_rise_ms);
+					write_ms(file, r.visible_ms);
+					fprintf(file, "\n");
+				}
+
+				// The digest keeps the output each stimulus is meant to drive.
+				const int key_output = stim.freq_hz <= 0.0   ? OUTPUT_PEAK
+						       : stim.freq_hz < 250.0 ? OUTPUT_BASS
+									      : OUTPUT_TREBLE;
+				const latency_result r = measure_output(trace, key_output);
+				if (r.half_rise_ms < 0.0)
+					snprintf(line, sizeof(line), " %s %s -", stim.name, kOutputNames[key_output]);
+				else
+					snprintf(line, sizeof(line), " %s %s %.1f ms (peak %.2f)", stim.name,
+						 kOutputNames[key_output], r.half_rise_ms, r.peak);
+				digest += line;
+			}
+			summary += digest;
+			summary += "\n";
+		}
+	}
+
+	const bool ok = fflush(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "latency.csv";
+	std::string summary;
+	if (!write_latency_table(path, summary)) {
+		fprintf(stderr, "Could not write latency table to '%s'\n", path);
+		return 1;
+	}
+	printf("Analysis latency table written to '%s'\n%s", path, summary.c_str());
+	return 0;
+}
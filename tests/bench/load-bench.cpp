@@ -0,0 +1,86 @@
+// Scene-collection load cost. For each plugin type, creates a few hundred
+// instances bound to an audio input the way OBS does when a collection
+// loads, then shows each one and runs its first frame, then destroys them
+// all. Creation is meant to stay cheap: GPU objects and audio bindings are
+// only made on first show, so that cost lands in the second column.
+//
+//   aw-load-bench <data-dir> [instances]     default 500
+
+#include "includes/effect-registry.hpp"
+#include "obs-stub.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" void register_audio_shader_source(void);
+extern "C" void register_audio_transform_filter(void);
+extern "C" void register_audio_shader_filter(void);
+
+static const char *kTypeIds[] = {"audio_shader_engine_source", "audio_shader_engine_transform_filter",
+				 "audio_shader_engine_filter"};
+
+using bench_clock = std::chrono::steady_clock;
+
+static double us_per(bench_clock::time_point t0, bench_clock::time_point t1, int count)
+{
+	return std::chrono::duration<double, std::micro>(t1 - t0).count() / count;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <data-dir> [instances]\n", argv[0]);
+		return 2;
+	}
+	const int count = argc > 2 ? std::max(1, atoi(argv[2])) : 500;
+
+	obs_stub_set_log_level(LOG_ERROR);
+	obs_stub_set_module_data_path(argv[1]);
+	register_audio_shader_source();
+	register_audio_transform_filter();
+	register_audio_shader_filter();
+	obs_source_t *input = obs_stub_add_audio_input("Load Input");
+
+	printf("%d instances per type, us per instance\n", count);
+	printf("%-38s %10s %12s %10s\n", "type", "create", "first show", "destroy");
+	for (const char *id : kTypeIds) {
+		const obs_source_info *info = obs_stub_find_source_info(id);
+		const bool filter = info->type == OBS_SOURCE_TYPE_FILTER;
+		std::vector<obs_source_t *> sources(size_t(count), nullptr);
+
+		const auto t0 = bench_clock::now();
+		for (obs_source_t *&source : sources) {
+			obs_data_t *settings = obs_data_create();
+			obs_data_set_string(settings, "audio_source", "Load Input");
+			source = obs_stub_create_source(id, "Load Instance", settings, filter ? input : nullptr);
+			obs_data_release(settings);
+		}
+
+		const auto t1 = bench_clock::now();
+		obs_stub_set_video_frame_time(1000000000ull);
+		for (obs_source_t *source : sources) {
+			void *data = obs_stub_source_data(source);
+			obs_stub_set_showing(source, true);
+			info->show(data);
+			info->video_tick(data, 1.0f / 60.0f);
+			obs_enter_graphics();
+			info->video_render(data, nullptr);
+			obs_leave_graphics();
+		}
+
+		const auto t2 = bench_clock::now();
+		for (obs_source_t *source : sources)
+			obs_stub_destroy_source(source);
+		const auto t3 = bench_clock::now();
+
+		printf("%-38s %10.2f %12.2f %10.2f\n", id, us_per(t0, t1, count), us_per(t1, t2, count),
+		       us_per(t2, t3, count));
+	}
+
+	obs_stub_remove_source(input);
+	effect_registry_stop();
+	return 0;
+}
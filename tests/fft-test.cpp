@@ -0,0 +1,196 @@
+// Checks both FFT paths, the size-specialised kernels and the generic
+// fft_inplace(), against a double-precision DFT for every size the analyzer
+// can run. For each size and input it checks:
+//  - the relative L2 error against the reference, scaled by log2(n);
+//  - Parseval: the spectrum's energy matches n times the signal's energy;
+//  - the round trip: the inverse transform, taken through the same path with
+//    the conjugate trick, gives the input back.
+// Sinusoids on an exact bin additionally must not leak into other bins.
+
+#include "includes/fft-kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr double kPi = 3.14159265358979323846;
+static constexpr double kFloatEps = 1.1920929e-7;
+
+// Bounds in units of kFloatEps * log2(n). Both paths measure about 0.1-0.2;
+// the margin covers compilers that contract into FMAs.
+static constexpr double kMaxErrorUnits = 1.0;
+static constexpr double kMaxRoundTripUnits = 2.0;
+static constexpr double kMaxParsevalUnits = 2.0;
+// Largest allowed off-bin magnitude for an on-bin sinusoid, relative to the
+// bin's own magnitude.
+static constexpr double kMaxLeakage = 1e-6;
+
+using cvec = std::vector<std::complex<float>>;
+using fft_path = std::function<void(cvec &)>;
+
+static int g_failures = 0;
+
+static void check(bool ok, const std::string &what, double value, double limit)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL %s: %.3g (limit %.3g)\n", what.c_str(), value, limit);
+		++g_failures;
+	}
+}
+
+// O(n^2) DFT in double precision with an exact integer angle reduction.
+static std::vector<std::complex<double>> reference_dft(const cvec &x)
+{
+	const size_t n = x.size();
+	std::vector<std::complex<double>> w(n);
+	for (size_t k = 0; k < n; ++k)
+		w[k] = std::polar(1.0, -2.0 * kPi * double(k) / double(n));
+
+	std::vector<std::complex<double>> out(n);
+	for (size_t k = 0; k < n; ++k) {
+		std::complex<double> sum = 0.0;
+		size_t idx = 0;
+		for (size_t i = 0; i < n; ++i) {
+			sum += std::complex<double>(x[i]) * w[idx];
+			idx += k;
+			if (idx >= n)
+				idx -= n;
+		}
+		out[k] = sum;
+	}
+	return out;
+}
+
+static double energy(const cvec &x)
+{
+	double e = 0.0;
+	for (const auto &v : x)
+		e += std::norm(std::complex<double>(v));
+	return e;
+}
+
+static void check_path(const char *path_name, const fft_path &fft, const char *input_name, const cvec &x,
+		       const std::vector<std::complex<double>> &ref, int sine_bin)
+{
+	const size_t n = x.size();
+	const double log_n = std::log2(double(n));
+	const std::string tag = std::string(path_name) + " n=" + std::to_string(n) + " " + input_name;
+
+	cvec y = x;
+	fft(y);
+
+	double err = 0.0;
+	double ref_energy = 0.0;
+	for (size_t k = 0; k < n; ++k) {
+		err += std::norm(std::complex<double>(y[k]) - ref[k]);
+		ref_energy += std::norm(ref[k]);
+	}
+	const double rel_err = std::sqrt(err / std::max(ref_energy, 1e-300));
+	const double err_limit = kMaxErrorUnits * kFloatEps * log_n;
+	check(rel_err <= err_limit, tag + " error vs DFT", rel_err, err_limit);
+
+	const double x_energy = energy(x);
+	const double parseval = std::fabs(energy(y) - x_energy * double(n)) / std::max(x_energy * double(n), 1e-300);
+	const double parseval_limit = kMaxParsevalUnits * kFloatEps * log_n;
+	check(parseval <= parseval_limit, tag + " Parseval", parseval, parseval_limit);
+
+	// Inverse through the forward path: x = conj(FFT(conj(X))) / n.
+	cvec z = y;
+	for (auto &v : z)
+		v = std::conj(v);
+	fft(z);
+	double rt_err = 0.0;
+	for (size_t i = 0; i < n; ++i)
+		rt_err += std::norm(std::complex<double>(std::conj(z[i])) / double(n) - std::complex<double>(x[i]));
+	const double rt_rel = std::sqrt(rt_err / std::max(x_energy, 1e-300));
+	const double rt_limit = kMaxRoundTripUnits * kFloatEps * log_n;
+	check(rt_rel <= rt_limit, tag + " round trip", rt_rel, rt_limit);
+
+	if (sine_bin > 0) {
+		const double peak = std::abs(std::complex<double>(y[(size_t)sine_bin]));
+		double leak = 0.0;
+		for (size_t k = 0; k < n; ++k) {
+			if (k != (size_t)sine_bin && k != n - (size_t)sine_bin)
+				leak = std::max(leak, std::abs(std::complex<double>(y[k])));
+		}
+		check(leak <= peak * kMaxLeakage, tag + " leakage", leak / peak, kMaxLeakage);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(79);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	for (size_t n = 256; n <= 8192; n <<= 1) {
+		const fft_kernel_fn kernel = fft_kernel_for_size(n);
+		if (!kernel) {
+			fprintf(stderr, "FAIL no specialised kernel for n=%zu\n", n);
+			++g_failures;
+			continue;
+		}
+		cvec twiddles;
+		fft_build_twiddles(twiddles, n);
+
+		const fft_path kernel_path = [kernel](cvec &a) { kernel(a.data()); };
+		const fft_path generic_path = [&twiddles](cvec &a) {
+			if (!fft_inplace(a, twiddles)) {
+				fprintf(stderr, "FAIL fft_inplace rejected n=%zu\n", a.size());
+				++g_failures;
+			}
+		};
+
+		struct test_input {
+			const char *name;
+			cvec x;
+			int sine_bin;
+		};
+		std::vector<test_input> inputs;
+
+		test_input random{"random", cvec(n), 0};
+		for (auto &v : random.x)
+			v = std::complex<float>(uniform(rng), uniform(rng));
+		inputs.push_back(random);
+
+		test_input impulse{"impulse", cvec(n), 0};
+		impulse.x[n / 3] = std::complex<float>(0.9f, 0.0f);
+		inputs.push_back(impulse);
+
+		// A real sinusoid on an exact bin, as the analyzer would feed.
+		const int bin = int(n / 16) + 3;
+		test_input sine{"sinusoid", cvec(n), bin};
+		for (size_t i = 0; i < n; ++i)
+			sine.x[i] = float(0.5 * std::sin(2.0 * kPi * double(bin) * double(i) / double(n) + 0.3));
+		inputs.push_back(sine);
+
+		for (const test_input &in : inputs) {
+			const std::vector<std::complex<double>> ref = reference_dft(in.x);
+			check_path("kernel", kernel_path, in.name, in.x, ref, in.sine_bin);
+			check_path("generic", generic_path, in.name, in.x, ref, in.sine_bin);
+		}
+		printf("n=%-5zu checked\n", n);
+	}
+
+	// Sizes outside the analyzer's range have no kernel, and the generic
+	// path refuses sizes that are not a power of two.
+	if (fft_kernel_for_size(128) || fft_kernel_for_size(16384) || fft_kernel_for_size(1000)) {
+		fprintf(stderr, "FAIL unexpected kernel for an unsupported size\n");
+		++g_failures;
+	}
+	cvec odd(1000);
+	cvec odd_twiddles;
+	fft_build_twiddles(odd_twiddles, odd.size());
+	if (fft_inplace(odd, odd_twiddles)) {
+		fprintf(stderr, "FAIL fft_inplace accepted n=1000\n");
+		++g_failures;
+	}
+
+	if (g_failures)
+		fprintf(stderr, "%d check(s) failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
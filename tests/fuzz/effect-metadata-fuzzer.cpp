@@ -0,0 +1,36 @@
+// libFuzzer target for parse_effect_metadata(). Any input must parse without
+// crashing, and every field must stay within the limits the property UI
+// relies on.
+
+#include "includes/effect-metadata.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+static void require(bool ok)
+{
+	if (!ok)
+		abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	std::istringstream in(std::string(reinterpret_cast<const char *>(data), size));
+	const effect_metadata meta = parse_effect_metadata(in);
+
+	require(meta.quality_tiers >= 1 && meta.quality_tiers <= kMaxQualityTiers);
+	require(meta.name.size() <= kMaxMetadataLabelLength);
+	for (const std::string &label : meta.option_labels)
+		require(label.size() <= kMaxMetadataLabelLength);
+	for (const std::string &label : meta.color_labels)
+		require(label.size() <= kMaxMetadataLabelLength);
+	for (const std::string &label : meta.tier_labels)
+		require(label.size() <= kMaxMetadataLabelLength);
+
+	// Nothing past the byte budget may be consumed.
+	const std::streamoff consumed = in.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in);
+	require(consumed >= 0 && size_t(consumed) <= kMaxMetadataBytes);
+	return 0;
+}
@@ -0,0 +1,141 @@
+// libFuzzer target for the analyzer's ingest path. The input is read as a
+// script of operations on one analyzer: audio packets of random length with
+// raw sample bits (NaN, Inf and denormals included), null and muted
+// channels, FFT size changes that resize the ring between packets, and ticks
+// on a clock that may stall or jump. After every tick all outputs must be
+// finite and in range.
+
+#include "includes/audio-analyzer.hpp"
+#include "obs-stub.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static constexpr size_t kMaxPacketFrames = 4096;
+static const int kFftSizes[] = {512, 1024, 2048, 4096, 8192};
+
+// Consumes the fuzz input front to back; reads past the end give zeros.
+struct fuzz_reader {
+	const uint8_t *data;
+	size_t size;
+
+	bool empty() const { return size == 0; }
+
+	uint32_t u32(size_t bytes)
+	{
+		uint32_t v = 0;
+		for (size_t i = 0; i < bytes && size > 0; ++i, ++data, --size)
+			v |= uint32_t(*data) << (8 * i);
+		return v;
+	}
+
+	float sample()
+	{
+		const uint32_t bits = u32(4);
+		float v;
+		memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+};
+
+static void require(bool ok)
+{
+	if (!ok)
+		abort();
+}
+
+static void require_unit(float v)
+{
+	require(std::isfinite(v) && v >= 0.0f && v <= 1.0f);
+}
+
+static void set_fft_size(audio_analyzer *a, int fft_size)
+{
+	obs_data_t *settings = obs_data_create();
+	audio_analyzer_defaults(settings);
+	obs_data_set_int(settings, "fft_size", fft_size);
+	audio_analyzer_update_settings(a, settings);
+	obs_data_release(settings);
+}
+
+static void check_outputs(const audio_analyzer *a)
+{
+	require_unit(a->level);
+	require_unit(a->peak);
+	require_unit(a->bass);
+	require_unit(a->mid);
+	require_unit(a->treble);
+	require_unit(a->section_change);
+	require(std::isfinite(a->energy_trend) && std::fabs(a->energy_trend) <= 1.0f);
+	for (float band : a->bands)
+		require_unit(band);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	static bool quiet = [] {
+		obs_stub_set_log_level(LOG_ERROR);
+		return true;
+	}();
+	(void)quiet;
+
+	fuzz_reader in{data, size};
+	auto a = std::make_unique<audio_analyzer>();
+	audio_analyzer_init(a.get(), nullptr);
+	set_fft_size(a.get(), 2048);
+	a->cpu_budget_ms = 0.0f;
+
+	std::vector<float> left(kMaxPacketFrames);
+	std::vector<float> right(kMaxPacketFrames);
+	uint64_t now = 1000000000ull;
+
+	for (int op = 0; op < 256 && !in.empty(); ++op) {
+		switch (in.u32(1) % 4) {
+		case 0:
+		case 1: {
+			const uint32_t flags = in.u32(1);
+			const size_t frames = in.u32(2) % (kMaxPacketFrames + 1);
+			// Only a few samples come from the input; the rest repeat them
+			// so long packets do not need long inputs.
+			const size_t unique = std::min<size_t>(frames, 16);
+			for (size_t i = 0; i < unique; ++i) {
+				left[i] = in.sample();
+				right[i] = in.sample();
+			}
+			for (size_t i = unique; i < frames; ++i) {
+				left[i] = left[i % unique];
+				right[i] = right[i % unique];
+			}
+			const float *l = (flags & 1) ? nullptr : left.data();
+			const float *r = (flags & 2) ? nullptr : right.data();
+			audio_analyzer_push_audio(a.get(), l, r, frames, (flags & 4) != 0);
+			break;
+		}
+		case 2:
+			set_fft_size(a.get(), kFftSizes[in.u32(1) % 5]);
+			break;
+		default: {
+			// Mostly frame-sized steps, sometimes a stall or a jump back.
+			const uint32_t step = in.u32(1);
+			if (step < 200)
+				now += 16666667ull;
+			else if (step < 240)
+				now += uint64_t(step) * 100000000ull;
+			else
+				now -= std::min<uint64_t>(now - 1, 50000000ull);
+			audio_analyzer_tick(a.get(), now);
+			check_outputs(a.get());
+			break;
+		}
+		}
+	}
+
+	audio_analyzer_tick(a.get(), now + 16666667ull);
+	check_outputs(a.get());
+	audio_analyzer_shutdown(a.get());
+	return 0;
+}
@@ -0,0 +1,40 @@
+// Stand-in for the libFuzzer driver on compilers without -fsanitize=fuzzer.
+// Runs LLVMFuzzerTestOneInput once per file named on the command line, or
+// per file inside a named directory, so corpora and crash reproducers can be
+// replayed anywhere.
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void run_file(const std::filesystem::path &path, int &count)
+{
+	std::ifstream in(path, std::ios::binary);
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	LLVMFuzzerTestOneInput(data.data(), data.size());
+	++count;
+}
+
+int main(int argc, char **argv)
+{
+	int count = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::filesystem::path path(argv[i]);
+		std::error_code ec;
+		if (std::filesystem::is_directory(path, ec)) {
+			for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+				if (entry.is_regular_file(ec))
+					run_file(entry.path(), count);
+			}
+		} else {
+			run_file(path, count);
+		}
+	}
+	printf("replayed %d input(s)\n", count);
+	return 0;
+}
@@ -0,0 +1,251 @@
+// Headless lifecycle stress for the three plugin types. Worker threads keep
+// creating, updating, showing, hiding and destroying shader sources and both
+// filters against the libobs stand-in, a graphics thread ticks and renders
+// whatever is alive every frame, and audio threads push packets into the
+// inputs the instances bind to, all at once. Run it under the asan and tsan
+// presets; on its own it also reports the throughput of each part.
+//
+//   aw-lifecycle-stress <data-dir> [seconds] [workers]
+//
+// Fails when the plugin logs an error or a sanitizer reports.
+
+#include "includes/analysis-pool.hpp"
+#include "includes/audio-source-index.hpp"
+#include "includes/effect-registry.hpp"
+#include "obs-stub.hpp"
+
+#include <util/platform.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" void register_audio_shader_source(void);
+extern "C" void register_audio_transform_filter(void);
+extern "C" void register_audio_shader_filter(void);
+
+static constexpr int kAudioInputs = 4;
+static constexpr size_t kAudioPacketFrames = 480;
+static constexpr int kSlotsPerWorker = 4;
+static const char *kTypeIds[] = {"audio_shader_engine_source", "audio_shader_engine_transform_filter",
+				 "audio_shader_engine_filter"};
+static const int kFftSizes[] = {512, 1024, 2048, 4096};
+
+// One live instance. The owning worker creates and destroys it under the
+// mutex; the graphics thread holds the mutex while it ticks and renders, so
+// it never sees a destroyed instance. Updates, shows and hides run without
+// it, racing the graphics thread as they do in OBS.
+struct stress_slot {
+	std::mutex mutex;
+	obs_source_t *source = nullptr;
+	const obs_source_info *info = nullptr;
+};
+
+struct stress_counters {
+	std::atomic<uint64_t> created{0};
+	std::atomic<uint64_t> updated{0};
+	std::atomic<uint64_t> toggled{0};
+	std::atomic<uint64_t> frames{0};
+	std::atomic<uint64_t> renders{0};
+	std::atomic<uint64_t> packets{0};
+};
+
+static std::atomic<bool> g_stop{false};
+static stress_counters g_count;
+static std::vector<obs_source_t *> g_inputs;
+
+static std::string input_name(int index)
+{
+	return "Stress Input " + std::to_string(index);
+}
+
+static void set_showing(obs_source_t *source, const obs_source_info *info, bool showing)
+{
+	obs_stub_set_showing(source, showing);
+	void *data = obs_stub_source_data(source);
+	if (showing && info->show)
+		info->show(data);
+	else if (!showing && info->hide)
+		info->hide(data);
+	g_count.toggled.fetch_add(1);
+}
+
+static void update_random(obs_source_t *source, const obs_source_info *info, std::mt19937 &rng)
+{
+	obs_data_t *settings = obs_source_get_settings(source);
+	obs_data_set_string(settings, "audio_source", input_name(int(rng() % kAudioInputs)).c_str());
+	obs_data_set_string(settings, "audio_source_uuid", "");
+	obs_data_set_int(settings, "fft_size", kFftSizes[rng() % 4]);
+	info->update(obs_stub_source_data(source), settings);
+	obs_data_release(settings);
+	g_count.updated.fetch_add(1);
+}
+
+static void worker_main(stress_slot *slots, size_t count, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	while (!g_stop.load()) {
+		stress_slot &slot = slots[rng() % count];
+
+		if (!slot.source) {
+			const char *id = kTypeIds[rng() % 3];
+			const obs_source_info *info = obs_stub_find_source_info(id);
+			obs_data_t *settings = obs_data_create();
+			obs_data_set_string(settings, "audio_source", input_name(int(rng() % kAudioInputs)).c_str());
+			obs_source_t *target = info->type == OBS_SOURCE_TYPE_FILTER ? g_inputs[rng() % kAudioInputs]
+										   : nullptr;
+
+			std::lock_guard<std::mutex> lock(slot.mutex);
+			slot.source = obs_stub_create_source(id, "Stress Instance", settings, target);
+			slot.info = info;
+			obs_data_release(settings);
+			if (!slot.source) {
+				fprintf(stderr, "FAIL could not create %s\n", id);
+				exit(1);
+			}
+			g_count.created.fetch_add(1);
+			continue;
+		}
+
+		switch (rng() % 4) {
+		case 0:
+			update_random(slot.source, slot.info, rng);
+			break;
+		case 1:
+			set_showing(slot.source, slot.info, true);
+			break;
+		case 2:
+			set_showing(slot.source, slot.info, false);
+			break;
+		default: {
+			std::lock_guard<std::mutex> lock(slot.mutex);
+			if (obs_source_showing(slot.source))
+				set_showing(slot.source, slot.info, false);
+			obs_stub_destroy_source(slot.source);
+			slot.source = nullptr;
+			slot.info = nullptr;
+			break;
+		}
+		}
+	}
+}
+
+static void graphics_main(std::vector<stress_slot> *slots)
+{
+	const auto frame = std::chrono::microseconds(16667);
+	auto next = std::chrono::steady_clock::now();
+	while (!g_stop.load()) {
+		obs_stub_set_video_frame_time(os_gettime_ns());
+		for (stress_slot &slot : *slots) {
+			std::lock_guard<std::mutex> lock(slot.mutex);
+			if (!slot.source)
+				continue;
+			void *data = obs_stub_source_data(slot.source);
+			if (slot.info->video_tick)
+				slot.info->video_tick(data, 1.0f / 60.0f);
+			obs_enter_graphics();
+			slot.info->video_render(data, nullptr);
+			obs_leave_graphics();
+			g_count.renders.fetch_add(1);
+		}
+		g_count.frames.fetch_add(1);
+		next += frame;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+// One thread per input, pushing packets at about the real audio rate.
+static void audio_main(obs_source_t *input, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+	std::vector<float> left(kAudioPacketFrames);
+	std::vector<float> right(kAudioPacketFrames);
+	const auto packet = std::chrono::microseconds(10000);
+	auto next = std::chrono::steady_clock::now();
+	while (!g_stop.load()) {
+		for (size_t i = 0; i < kAudioPacketFrames; ++i) {
+			left[i] = noise(rng);
+			right[i] = noise(rng);
+		}
+		audio_data audio{};
+		audio.data[0] = reinterpret_cast<uint8_t *>(left.data());
+		audio.data[1] = reinterpret_cast<uint8_t *>(right.data());
+		audio.frames = uint32_t(kAudioPacketFrames);
+		audio.timestamp = os_gettime_ns();
+		obs_stub_emit_audio(input, &audio, false);
+		g_count.packets.fetch_add(1);
+		next += packet;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <data-dir> [seconds] [workers]\n", argv[0]);
+		return 2;
+	}
+	const double seconds = argc > 2 ? atof(argv[2]) : 3.0;
+	const int workers = argc > 3 ? std::max(1, atoi(argv[3])) : 4;
+
+	obs_stub_set_log_level(LOG_ERROR);
+	obs_stub_set_module_data_path(argv[1]);
+	analysis_pool_start(2, thread_tuning{});
+	audio_source_index_start();
+	register_audio_shader_source();
+	register_audio_transform_filter();
+	register_audio_shader_filter();
+
+	for (int i = 0; i < kAudioInputs; ++i)
+		g_inputs.push_back(obs_stub_add_audio_input(input_name(i).c_str()));
+
+	// Each worker owns a disjoint run of slots; the graphics thread walks them all.
+	std::vector<stress_slot> all_slots(size_t(workers) * kSlotsPerWorker);
+	std::vector<std::thread> threads;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kAudioInputs; ++i)
+		threads.emplace_back(audio_main, g_inputs[i], unsigned(100 + i));
+	threads.emplace_back(graphics_main, &all_slots);
+	for (int w = 0; w < workers; ++w)
+		threads.emplace_back(worker_main, all_slots.data() + size_t(w) * kSlotsPerWorker, size_t(kSlotsPerWorker),
+				     unsigned(w + 1));
+
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	g_stop.store(true);
+	for (std::thread &t : threads)
+		t.join();
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (stress_slot &slot : all_slots) {
+		if (slot.source)
+			obs_stub_destroy_source(slot.source);
+	}
+	for (obs_source_t *input : g_inputs)
+		obs_stub_remove_source(input);
+	audio_source_index_stop();
+	effect_registry_stop();
+	analysis_pool_stop();
+
+	printf("%.1f s, %d workers\n", elapsed, workers);
+	printf("  create/destroy  %10.0f /s\n", double(g_count.created.load()) / elapsed);
+	printf("  update          %10.0f /s\n", double(g_count.updated.load()) / elapsed);
+	printf("  show/hide       %10.0f /s\n", double(g_count.toggled.load()) / elapsed);
+	printf("  frames          %10.0f /s (%.0f renders/s)\n", double(g_count.frames.load()) / elapsed,
+	       double(g_count.renders.load()) / elapsed);
+	printf("  audio packets   %10.0f /s\n", double(g_count.packets.load()) / elapsed);
+
+	if (obs_stub_error_count() > 0) {
+		fprintf(stderr, "FAIL %u error(s) logged\n", obs_stub_error_count());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,116 @@
+// Feeds the song-structure stage synthetic band frames on a 60 fps clock:
+// 20 s of quiet pads, 20 s of loud drums, then the pads again. The golden
+// fixtures are too short to fill the history or clear the refractory period,
+// so this is what pins the outputs down. It checks:
+//  - no boundary while the pads settle or during the steady drum section;
+//  - section_change spikes within 1.5 s of each change;
+//  - energy_trend is positive after the rise and negative after the fall.
+// The run is repeated with a non-zero phase, as given to later scheduler
+// slots.
+
+#include "includes/song-structure.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+static constexpr int kBands = 32;
+static constexpr double kFps = 60.0;
+static constexpr double kSectionSec = 20.0;
+// Largest allowed delay between a change in the audio and its boundary.
+static constexpr double kMaxDetectSec = 1.5;
+static constexpr float kSpike = 0.9f;
+static constexpr float kQuiet = 0.5f;
+static constexpr float kMinTrend = 0.5f;
+
+static int g_failures = 0;
+
+static void check(bool ok, const std::string &what, double value)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL %s: %.3f\n", what.c_str(), value);
+		++g_failures;
+	}
+}
+
+// Pads: energy in the low bands, little above. Drums: broadband hits twice
+// a second that decay over the beat. Both get a little noise so the adaptive
+// threshold has something to follow.
+static float make_frame(double t, std::mt19937 &rng, float *bands)
+{
+	std::uniform_real_distribution<float> jitter(-0.03f, 0.03f);
+	const bool drums = t >= kSectionSec && t < kSectionSec * 2.0;
+	if (!drums) {
+		for (int b = 0; b < kBands; ++b)
+			bands[b] = std::clamp((b < kBands / 4 ? 0.35f : 0.05f) + jitter(rng), 0.0f, 1.0f);
+		return std::clamp(0.15f + jitter(rng), 0.0f, 1.0f);
+	}
+
+	const double beat = std::fmod(t * 2.0, 1.0);
+	const float hit = float(std::exp(-beat * 6.0));
+	for (int b = 0; b < kBands; ++b)
+		bands[b] = std::clamp(0.55f + 0.4f * hit + jitter(rng), 0.0f, 1.0f);
+	return std::clamp(0.6f + 0.35f * hit + jitter(rng), 0.0f, 1.0f);
+}
+
+static void run(uint64_t phase_ns)
+{
+	const std::string tag = "phase " + std::to_string(phase_ns / 1000000) + " ms: ";
+	std::mt19937 rng(1234);
+	song_structure s;
+	s.phase_ns = phase_ns;
+
+	float spike_before_rise = 0.0f;
+	float spike_after_rise = 0.0f;
+	float spike_in_drums = 0.0f;
+	float spike_after_fall = 0.0f;
+	float trend_after_rise = -1.0f;
+	float trend_after_fall = 1.0f;
+
+	const float dt = float(1.0 / kFps);
+	const int frames = int(kSectionSec * 3.0 * kFps);
+	for (int i = 0; i < frames; ++i) {
+		const double t = double(i) / kFps;
+		float bands[kBands];
+		const float energy = make_frame(t, rng, bands);
+		song_structure_update(&s, bands, kBands, energy, 1000000000ull + uint64_t(t * 1e9), dt);
+
+		const double rise = kSectionSec;
+		const double fall = kSectionSec * 2.0;
+		if (t < rise)
+			spike_before_rise = std::max(spike_before_rise, s.section_change);
+		else if (t < rise + kMaxDetectSec)
+			spike_after_rise = std::max(spike_after_rise, s.section_change);
+		else if (t >= rise + 6.0 && t < fall)
+			spike_in_drums = std::max(spike_in_drums, s.section_change);
+		else if (t >= fall && t < fall + kMaxDetectSec)
+			spike_after_fall = std::max(spike_after_fall, s.section_change);
+
+		// Half the history is past the change three seconds after it.
+		if (t >= rise + 2.5 && t < rise + 3.5)
+			trend_after_rise = std::max(trend_after_rise, s.energy_trend);
+		if (t >= fall + 2.5 && t < fall + 3.5)
+			trend_after_fall = std::min(trend_after_fall, s.energy_trend);
+	}
+
+	check(spike_before_rise < kQuiet, tag + "section_change during the opening pads", spike_before_rise);
+	check(spike_after_rise >= kSpike, tag + "section_change after the drums come in", spike_after_rise);
+	check(spike_in_drums < kQuiet, tag + "section_change during steady drums", spike_in_drums);
+	check(spike_after_fall >= kSpike, tag + "section_change after the drums stop", spike_after_fall);
+	check(trend_after_rise >= kMinTrend, tag + "energy_trend after the rise", trend_after_rise);
+	check(trend_after_fall <= -kMinTrend, tag + "energy_trend after the fall", trend_after_fall);
+	printf("%srise spike %.2f, fall spike %.2f, trend %+.2f / %+.2f\n", tag.c_str(), spike_after_rise,
+	       spike_after_fall, trend_after_rise, trend_after_fall);
+}
+
+int main()
+{
+	run(0);
+	run(kSongFrameNs * 7 / 12);
+
+	if (g_failures)
+		fprintf(stderr, "%d check(s) failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
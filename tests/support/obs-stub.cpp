@@ -0,0 +1,1182 @@
+#include "obs-stub.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <util/platform.h>
+#include <util/threading.h>
+
+// All opaque libobs handles handed to the plugin point at the stub_* types
+// below. They are never named after the libobs structs so nothing here can
+// clash with a definition pulled in through the public headers.
+
+struct stub_value {
+	bool is_string = false;
+	std::string str;
+	double num = 0.0;
+};
+
+struct stub_data {
+	std::atomic<long> refs{1};
+	std::mutex mutex;
+	std::map<std::string, stub_value> user;
+	std::map<std::string, stub_value> defaults;
+};
+
+struct stub_source;
+
+struct stub_weak {
+	stub_source *source = nullptr;
+};
+
+struct stub_source {
+	std::string id;
+	std::string name;
+	std::string uuid;
+	obs_source_type type = OBS_SOURCE_TYPE_INPUT;
+	uint32_t flags = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::atomic<long> refs{1};
+	std::atomic<bool> removed{false};
+	std::atomic<bool> showing{false};
+	obs_data_t *settings = nullptr;
+	stub_source *target = nullptr;
+	const obs_source_info *info = nullptr;
+	void *data = nullptr;
+	stub_weak weak;
+
+	std::mutex audio_mutex;
+	std::vector<std::pair<obs_source_audio_capture_t, void *>> audio_callbacks;
+};
+
+struct stub_property {
+	std::string name;
+};
+
+struct stub_properties {
+	std::vector<std::unique_ptr<stub_property>> props;
+	std::vector<obs_properties_t *> groups;
+	void *param = nullptr;
+	void (*destroy)(void *) = nullptr;
+};
+
+struct stub_dir {
+	std::filesystem::directory_iterator it;
+	os_dirent entry{};
+};
+
+// Every graphics object; the stub only needs something unique to point at.
+struct stub_gs_object {
+	int unused = 0;
+};
+
+static std::atomic<int> g_log_level{LOG_WARNING};
+static std::atomic<uint32_t> g_error_count{0};
+static std::atomic<uint32_t> g_warning_count{0};
+
+static std::mutex g_path_mutex;
+static std::string g_data_path;
+static std::string g_config_path;
+
+static std::atomic<uint32_t> g_video_width{1920};
+static std::atomic<uint32_t> g_video_height{1080};
+static std::atomic<uint32_t> g_video_fps{60};
+static std::atomic<uint64_t> g_video_frame_time{0};
+
+// Sources are kept until exit so a stale weak reference never points at
+// freed memory; removed ones are only unlisted.
+static std::recursive_mutex g_sources_mutex;
+static std::vector<std::unique_ptr<stub_source>> g_all_sources;
+static std::vector<stub_source *> g_sources;
+static uint64_t g_next_uuid = 1;
+
+static std::mutex g_info_mutex;
+static std::vector<std::unique_ptr<obs_source_info>> g_source_infos;
+
+static std::recursive_mutex g_graphics_mutex;
+static thread_local int t_graphics_depth = 0;
+static stub_gs_object g_shared_object;
+
+static stub_gs_object g_signal_handler;
+
+static stub_data *to_stub(obs_data_t *data)
+{
+	return reinterpret_cast<stub_data *>(data);
+}
+
+static stub_source *to_stub(const obs_source_t *source)
+{
+	return reinterpret_cast<stub_source *>(const_cast<obs_source_t *>(source));
+}
+
+static stub_properties *to_stub(obs_properties_t *props)
+{
+	return reinterpret_cast<stub_properties *>(props);
+}
+
+static char *dup_string(const std::string &s)
+{
+	char *out = static_cast<char *>(malloc(s.size() + 1));
+	memcpy(out, s.c_str(), s.size() + 1);
+	return out;
+}
+
+static const stub_value *find_value(stub_data *d, const char *name)
+{
+	auto it = d->user.find(name);
+	if (it != d->user.end())
+		return &it->second;
+	it = d->defaults.find(name);
+	return it != d->defaults.end() ? &it->second : nullptr;
+}
+
+static void set_number(obs_data_t *data, const char *name, double value, bool is_default)
+{
+	stub_data *d = to_stub(data);
+	if (!d || !name)
+		return;
+	std::lock_guard<std::mutex> lock(d->mutex);
+	stub_value &v = is_default ? d->defaults[name] : d->user[name];
+	v.is_string = false;
+	v.num = value;
+}
+
+static void set_string(obs_data_t *data, const char *name, const char *value, bool is_default)
+{
+	stub_data *d = to_stub(data);
+	if (!d || !name)
+		return;
+	std::lock_guard<std::mutex> lock(d->mutex);
+	stub_value &v = is_default ? d->defaults[name] : d->user[name];
+	v.is_string = true;
+	v.str = value ? value : "";
+}
+
+static double get_number(obs_data_t *data, const char *name)
+{
+	stub_data *d = to_stub(data);
+	if (!d || !name)
+		return 0.0;
+	std::lock_guard<std::mutex> lock(d->mutex);
+	const stub_value *v = find_value(d, name);
+	return v && !v->is_string ? v->num : 0.0;
+}
+
+static obs_source_t *add_source_ref(stub_source *s)
+{
+	s->refs.fetch_add(1);
+	return reinterpret_cast<obs_source_t *>(s);
+}
+
+static void unlist_source(stub_source *s)
+{
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	s->removed.store(true);
+	g_sources.erase(std::remove(g_sources.begin(), g_sources.end(), s), g_sources.end());
+}
+
+static stub_source *new_source(const char *name)
+{
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	g_all_sources.push_back(std::make_unique<stub_source>());
+	stub_source *s = g_all_sources.back().get();
+	s->name = name ? name : "";
+	char uuid[64];
+	snprintf(uuid, sizeof(uuid), "00000000-0000-4000-8000-%012llx", (unsigned long long)g_next_uuid++);
+	s->uuid = uuid;
+	s->weak.source = s;
+	return s;
+}
+
+void obs_stub_set_log_level(int level)
+{
+	g_log_level.store(level);
+}
+
+uint32_t obs_stub_error_count()
+{
+	return g_error_count.load();
+}
+
+uint32_t obs_stub_warning_count()
+{
+	return g_warning_count.load();
+}
+
+void obs_stub_set_module_data_path(const char *path)
+{
+	std::lock_guard<std::mutex> lock(g_path_mutex);
+	g_data_path = path ? path : "";
+}
+
+void obs_stub_set_module_config_path(const char *path)
+{
+	std::lock_guard<std::mutex> lock(g_path_mutex);
+	g_config_path = path ? path : "";
+}
+
+void obs_stub_set_video(uint32_t width, uint32_t height, uint32_t fps)
+{
+	g_video_width.store(width);
+	g_video_height.store(height);
+	g_video_fps.store(std::max<uint32_t>(1, fps));
+}
+
+void obs_stub_set_video_frame_time(uint64_t ns)
+{
+	g_video_frame_time.store(ns);
+}
+
+obs_source_t *obs_stub_add_audio_input(const char *name)
+{
+	stub_source *s = new_source(name);
+	s->id = "stub_audio_input";
+	s->flags = OBS_SOURCE_AUDIO | OBS_SOURCE_VIDEO;
+	s->width = 1280;
+	s->height = 720;
+	s->settings = obs_data_create();
+
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	g_sources.push_back(s);
+	return reinterpret_cast<obs_source_t *>(s);
+}
+
+void obs_stub_remove_source(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return;
+	unlist_source(s);
+	obs_source_release(source);
+}
+
+void obs_stub_emit_audio(obs_source_t *source, const audio_data *audio, bool muted)
+{
+	stub_source *s = to_stub(source);
+	if (!s || !audio)
+		return;
+	std::lock_guard<std::mutex> lock(s->audio_mutex);
+	for (const auto &cb : s->audio_callbacks)
+		cb.first(cb.second, source, audio, muted);
+}
+
+const obs_source_info *obs_stub_find_source_info(const char *id)
+{
+	std::lock_guard<std::mutex> lock(g_info_mutex);
+	for (const auto &info : g_source_infos) {
+		if (id && info->id && strcmp(info->id, id) == 0)
+			return info.get();
+	}
+	return nullptr;
+}
+
+obs_source_t *obs_stub_create_source(const char *id, const char *name, obs_data_t *settings,
+				     obs_source_t *filter_target)
+{
+	const obs_source_info *info = obs_stub_find_source_info(id);
+	if (!info || !info->create)
+		return nullptr;
+
+	stub_source *s = new_source(name);
+	s->id = id;
+	s->type = info->type;
+	s->flags = info->output_flags;
+	s->info = info;
+	s->target = to_stub(filter_target);
+	if (settings) {
+		to_stub(settings)->refs.fetch_add(1);
+		s->settings = settings;
+	} else {
+		s->settings = obs_data_create();
+	}
+	if (info->get_defaults)
+		info->get_defaults(s->settings);
+
+	{
+		std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+		g_sources.push_back(s);
+	}
+
+	obs_source_t *source = reinterpret_cast<obs_source_t *>(s);
+	s->data = info->create(s->settings, source);
+	if (!s->data) {
+		unlist_source(s);
+		obs_data_release(s->settings);
+		s->settings = nullptr;
+		return nullptr;
+	}
+	return source;
+}
+
+void obs_stub_destroy_source(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return;
+	unlist_source(s);
+	if (s->info && s->info->destroy && s->data)
+		s->info->destroy(s->data);
+	s->data = nullptr;
+	obs_data_release(s->settings);
+	s->settings = nullptr;
+	s->refs.store(0);
+}
+
+void *obs_stub_source_data(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	return s ? s->data : nullptr;
+}
+
+void obs_stub_set_showing(obs_source_t *source, bool showing)
+{
+	if (stub_source *s = to_stub(source))
+		s->showing.store(showing);
+}
+
+extern "C" {
+
+// ---------------------------------------------------------------------------
+// Memory, logging, module
+// ---------------------------------------------------------------------------
+void bfree(void *ptr)
+{
+	free(ptr);
+}
+
+void blog(int log_level, const char *format, ...)
+{
+	if (log_level <= LOG_ERROR)
+		g_error_count.fetch_add(1);
+	else if (log_level <= LOG_WARNING)
+		g_warning_count.fetch_add(1);
+	if (log_level > g_log_level.load())
+		return;
+
+	char msg[4096];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(msg, sizeof(msg), format, args);
+	va_end(args);
+	fprintf(stderr, "%s\n", msg);
+}
+
+obs_module_t *obs_current_module(void)
+{
+	return nullptr;
+}
+
+char *obs_find_module_file(obs_module_t *, const char *file)
+{
+	std::lock_guard<std::mutex> lock(g_path_mutex);
+	if (g_data_path.empty() || !file)
+		return nullptr;
+	const std::string path = g_data_path + "/" + file;
+	std::error_code ec;
+	return std::filesystem::exists(path, ec) ? dup_string(path) : nullptr;
+}
+
+char *obs_module_get_config_path(obs_module_t *, const char *file)
+{
+	std::lock_guard<std::mutex> lock(g_path_mutex);
+	if (g_config_path.empty() || !file)
+		return nullptr;
+	return dup_string(g_config_path + "/" + file);
+}
+
+void obs_register_source_s(const struct obs_source_info *info, size_t size)
+{
+	auto copy = std::make_unique<obs_source_info>();
+	memcpy(copy.get(), info, std::min(size, sizeof(obs_source_info)));
+	std::lock_guard<std::mutex> lock(g_info_mutex);
+	g_source_infos.push_back(std::move(copy));
+}
+
+// ---------------------------------------------------------------------------
+// Signals
+// ---------------------------------------------------------------------------
+signal_handler_t *obs_get_signal_handler(void)
+{
+	return reinterpret_cast<signal_handler_t *>(&g_signal_handler);
+}
+
+void signal_handler_connect(signal_handler_t *, const char *, signal_callback_t, void *) {}
+
+void signal_handler_disconnect(signal_handler_t *, const char *, signal_callback_t, void *) {}
+
+bool calldata_get_data(const calldata_t *, const char *, void *, size_t)
+{
+	return false;
+}
+
+bool calldata_get_string(const calldata_t *, const char *, const char **str)
+{
+	if (str)
+		*str = nullptr;
+	return false;
+}
+
+// ---------------------------------------------------------------------------
+// Core
+// ---------------------------------------------------------------------------
+bool obs_get_video_info(struct obs_video_info *ovi)
+{
+	*ovi = {};
+	ovi->base_width = g_video_width.load();
+	ovi->base_height = g_video_height.load();
+	ovi->output_width = ovi->base_width;
+	ovi->output_height = ovi->base_height;
+	ovi->fps_num = g_video_fps.load();
+	ovi->fps_den = 1;
+	return true;
+}
+
+bool obs_get_audio_info(struct obs_audio_info *oai)
+{
+	*oai = {};
+	oai->samples_per_sec = 48000;
+	return true;
+}
+
+uint64_t obs_get_video_frame_time(void)
+{
+	return g_video_frame_time.load();
+}
+
+void obs_enter_graphics(void)
+{
+	g_graphics_mutex.lock();
+	++t_graphics_depth;
+}
+
+void obs_leave_graphics(void)
+{
+	--t_graphics_depth;
+	g_graphics_mutex.unlock();
+}
+
+gs_effect_t *obs_get_base_effect(enum obs_base_effect)
+{
+	return reinterpret_cast<gs_effect_t *>(&g_shared_object);
+}
+
+obs_source_t *obs_get_source_by_name(const char *name)
+{
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	for (stub_source *s : g_sources) {
+		if (name && s->name == name)
+			return add_source_ref(s);
+	}
+	return nullptr;
+}
+
+obs_source_t *obs_get_source_by_uuid(const char *uuid)
+{
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	for (stub_source *s : g_sources) {
+		if (uuid && s->uuid == uuid)
+			return add_source_ref(s);
+	}
+	return nullptr;
+}
+
+void obs_enum_sources(bool (*enum_proc)(void *, obs_source_t *), void *param)
+{
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	for (stub_source *s : g_sources) {
+		if (s->type == OBS_SOURCE_TYPE_INPUT && !enum_proc(param, reinterpret_cast<obs_source_t *>(s)))
+			break;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Sources
+// ---------------------------------------------------------------------------
+obs_weak_source_t *obs_source_get_weak_source(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	return s ? reinterpret_cast<obs_weak_source_t *>(&s->weak) : nullptr;
+}
+
+obs_source_t *obs_weak_source_get_source(obs_weak_source_t *weak)
+{
+	auto *w = reinterpret_cast<stub_weak *>(weak);
+	if (!w)
+		return nullptr;
+	std::lock_guard<std::recursive_mutex> lock(g_sources_mutex);
+	if (w->source->removed.load() || w->source->refs.load() <= 0)
+		return nullptr;
+	return add_source_ref(w->source);
+}
+
+void obs_weak_source_release(obs_weak_source_t *) {}
+
+void obs_source_release(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (s && s->refs.fetch_sub(1) == 1) {
+		unlist_source(s);
+		obs_data_release(std::exchange(s->settings, nullptr));
+	}
+}
+
+void obs_source_add_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback, void *param)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return;
+	std::lock_guard<std::mutex> lock(s->audio_mutex);
+	s->audio_callbacks.emplace_back(callback, param);
+}
+
+void obs_source_remove_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback, void *param)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return;
+	std::lock_guard<std::mutex> lock(s->audio_mutex);
+	auto &cbs = s->audio_callbacks;
+	auto it = std::find(cbs.begin(), cbs.end(), std::make_pair(callback, param));
+	if (it != cbs.end())
+		cbs.erase(it);
+}
+
+const char *obs_source_get_name(const obs_source_t *source)
+{
+	return source ? to_stub(source)->name.c_str() : nullptr;
+}
+
+const char *obs_source_get_uuid(const obs_source_t *source)
+{
+	return source ? to_stub(source)->uuid.c_str() : nullptr;
+}
+
+uint32_t obs_source_get_output_flags(const obs_source_t *source)
+{
+	return source ? to_stub(source)->flags : 0;
+}
+
+enum obs_source_type obs_source_get_type(const obs_source_t *source)
+{
+	return source ? to_stub(source)->type : OBS_SOURCE_TYPE_INPUT;
+}
+
+obs_data_t *obs_source_get_settings(const obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (!s || !s->settings)
+		return nullptr;
+	to_stub(s->settings)->refs.fetch_add(1);
+	return s->settings;
+}
+
+bool obs_source_audio_active(const obs_source_t *source)
+{
+	return source && (to_stub(source)->flags & OBS_SOURCE_AUDIO);
+}
+
+bool obs_source_active(const obs_source_t *source)
+{
+	return source && to_stub(source)->showing.load();
+}
+
+bool obs_source_showing(const obs_source_t *source)
+{
+	return source && to_stub(source)->showing.load();
+}
+
+obs_source_t *obs_filter_get_target(const obs_source_t *filter)
+{
+	return filter ? reinterpret_cast<obs_source_t *>(to_stub(filter)->target) : nullptr;
+}
+
+uint32_t obs_source_get_base_width(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return 0;
+	if (s->info && s->info->get_width && s->data)
+		return s->info->get_width(s->data);
+	return s->width;
+}
+
+uint32_t obs_source_get_base_height(obs_source_t *source)
+{
+	stub_source *s = to_stub(source);
+	if (!s)
+		return 0;
+	if (s->info && s->info->get_height && s->data)
+		return s->info->get_height(s->data);
+	return s->height;
+}
+
+void obs_source_skip_video_filter(obs_source_t *) {}
+
+bool obs_source_process_filter_begin(obs_source_t *, enum gs_color_format, enum obs_allow_direct_render)
+{
+	return true;
+}
+
+void obs_source_process_filter_end(obs_source_t *, gs_effect_t *, uint32_t, uint32_t) {}
+
+void obs_source_process_filter_tech_end(obs_source_t *, gs_effect_t *, uint32_t, uint32_t, const char *) {}
+
+// ---------------------------------------------------------------------------
+// Settings
+// ---------------------------------------------------------------------------
+obs_data_t *obs_data_create()
+{
+	return reinterpret_cast<obs_data_t *>(new stub_data);
+}
+
+obs_data_t *obs_data_create_from_json_file_safe(const char *, const char *)
+{
+	return nullptr;
+}
+
+bool obs_data_save_json_safe(obs_data_t *, const char *, const char *, const char *)
+{
+	return false;
+}
+
+void obs_data_release(obs_data_t *data)
+{
+	stub_data *d = to_stub(data);
+	if (d && d->refs.fetch_sub(1) == 1)
+		delete d;
+}
+
+bool obs_data_has_user_value(obs_data_t *data, const char *name)
+{
+	stub_data *d = to_stub(data);
+	if (!d || !name)
+		return false;
+	std::lock_guard<std::mutex> lock(d->mutex);
+	return d->user.count(name) != 0;
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name)
+{
+	stub_data *d = to_stub(data);
+	if (!d || !name)
+		return "";
+	std::lock_guard<std::mutex> lock(d->mutex);
+	const stub_value *v = find_value(d, name);
+	return v && v->is_string ? v->str.c_str() : "";
+}
+
+long long obs_data_get_int(obs_data_t *data, const char *name)
+{
+	return (long long)get_number(data, name);
+}
+
+double obs_data_get_double(obs_data_t *data, const char *name)
+{
+	return get_number(data, name);
+}
+
+bool obs_data_get_bool(obs_data_t *data, const char *name)
+{
+	return get_number(data, name) != 0.0;
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val)
+{
+	set_string(data, name, val, false);
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val)
+{
+	set_number(data, name, double(val), false);
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val)
+{
+	set_number(data, name, val ? 1.0 : 0.0, false);
+}
+
+void obs_data_set_double(obs_data_t *data, const char *name, double val)
+{
+	set_number(data, name, val, false);
+}
+
+void obs_data_set_default_string(obs_data_t *data, const char *name, const char *val)
+{
+	set_string(data, name, val, true);
+}
+
+void obs_data_set_default_int(obs_data_t *data, const char *name, long long val)
+{
+	set_number(data, name, double(val), true);
+}
+
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val)
+{
+	set_number(data, name, val ? 1.0 : 0.0, true);
+}
+
+void obs_data_set_default_double(obs_data_t *data, const char *name, double val)
+{
+	set_number(data, name, val, true);
+}
+
+// ---------------------------------------------------------------------------
+// Properties
+// ---------------------------------------------------------------------------
+static obs_property_t *add_property(obs_properties_t *props, const char *name)
+{
+	stub_properties *p = to_stub(props);
+	if (!p)
+		return nullptr;
+	p->props.push_back(std::make_unique<stub_property>());
+	p->props.back()->name = name ? name : "";
+	return reinterpret_cast<obs_property_t *>(p->props.back().get());
+}
+
+obs_properties_t *obs_properties_create(void)
+{
+	return reinterpret_cast<obs_properties_t *>(new stub_properties);
+}
+
+void obs_properties_destroy(obs_properties_t *props)
+{
+	stub_properties *p = to_stub(props);
+	if (!p)
+		return;
+	if (p->destroy)
+		p->destroy(p->param);
+	for (obs_properties_t *group : p->groups)
+		obs_properties_destroy(group);
+	delete p;
+}
+
+void obs_properties_set_param(obs_properties_t *props, void *param, void (*destroy)(void *param))
+{
+	stub_properties *p = to_stub(props);
+	if (!p)
+		return;
+	if (p->destroy)
+		p->destroy(p->param);
+	p->param = param;
+	p->destroy = destroy;
+}
+
+void *obs_properties_get_param(obs_properties_t *props)
+{
+	stub_properties *p = to_stub(props);
+	return p ? p->param : nullptr;
+}
+
+void obs_properties_remove_by_name(obs_properties_t *props, const char *property)
+{
+	stub_properties *p = to_stub(props);
+	if (!p || !property)
+		return;
+	auto &v = p->props;
+	v.erase(std::remove_if(v.begin(), v.end(), [&](const auto &prop) { return prop->name == property; }),
+		v.end());
+}
+
+obs_property_t *obs_properties_get(obs_properties_t *props, const char *property)
+{
+	stub_properties *p = to_stub(props);
+	if (!p || !property)
+		return nullptr;
+	for (const auto &prop : p->props) {
+		if (prop->name == property)
+			return reinterpret_cast<obs_property_t *>(prop.get());
+	}
+	for (obs_properties_t *group : p->groups) {
+		if (obs_property_t *found = obs_properties_get(group, property))
+			return found;
+	}
+	return nullptr;
+}
+
+obs_property_t *obs_properties_add_bool(obs_properties_t *props, const char *name, const char *)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_int(obs_properties_t *props, const char *name, const char *, int, int, int)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_int_slider(obs_properties_t *props, const char *name, const char *, int, int,
+					      int)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_float_slider(obs_properties_t *props, const char *name, const char *, double,
+						double, double)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_text(obs_properties_t *props, const char *name, const char *, enum obs_text_type)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_path(obs_properties_t *props, const char *name, const char *, enum obs_path_type,
+					const char *, const char *)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_list(obs_properties_t *props, const char *name, const char *,
+					enum obs_combo_type, enum obs_combo_format)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_color(obs_properties_t *props, const char *name, const char *)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_button(obs_properties_t *props, const char *name, const char *,
+					  obs_property_clicked_t)
+{
+	return add_property(props, name);
+}
+
+obs_property_t *obs_properties_add_group(obs_properties_t *props, const char *name, const char *,
+					 enum obs_group_type, obs_properties_t *group)
+{
+	if (stub_properties *p = to_stub(props))
+		p->groups.push_back(group);
+	return add_property(props, name);
+}
+
+void obs_property_set_modified_callback(obs_property_t *, obs_property_modified_t) {}
+
+void obs_property_set_enabled(obs_property_t *, bool) {}
+
+void obs_property_set_description(obs_property_t *, const char *) {}
+
+void obs_property_set_long_description(obs_property_t *, const char *) {}
+
+size_t obs_property_list_add_string(obs_property_t *, const char *, const char *)
+{
+	return 0;
+}
+
+size_t obs_property_list_add_int(obs_property_t *, const char *, long long)
+{
+	return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Graphics. Created objects are real allocations so leaks and double frees
+// show up under ASan; handles owned by another object share one dummy.
+// ---------------------------------------------------------------------------
+static stub_gs_object *new_gs_object()
+{
+	return new stub_gs_object;
+}
+
+static void delete_gs_object(void *object)
+{
+	delete static_cast<stub_gs_object *>(object);
+}
+
+static void *shared_gs_object()
+{
+	return &g_shared_object;
+}
+
+graphics_t *gs_get_context(void)
+{
+	return t_graphics_depth > 0 ? static_cast<graphics_t *>(shared_gs_object()) : nullptr;
+}
+
+gs_effect_t *gs_effect_create(const char *effect_string, const char *, char **error_string)
+{
+	if (error_string)
+		*error_string = nullptr;
+	if (!effect_string || !*effect_string)
+		return nullptr;
+	return reinterpret_cast<gs_effect_t *>(new_gs_object());
+}
+
+gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string)
+{
+	if (error_string)
+		*error_string = nullptr;
+	std::error_code ec;
+	if (!file || !std::filesystem::exists(file, ec))
+		return nullptr;
+	return reinterpret_cast<gs_effect_t *>(new_gs_object());
+}
+
+void gs_effect_destroy(gs_effect_t *effect)
+{
+	delete_gs_object(effect);
+}
+
+gs_technique_t *gs_effect_get_technique(const gs_effect_t *, const char *)
+{
+	return static_cast<gs_technique_t *>(shared_gs_object());
+}
+
+gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *, const char *)
+{
+	return static_cast<gs_eparam_t *>(shared_gs_object());
+}
+
+bool gs_effect_loop(gs_effect_t *, const char *)
+{
+	return false;
+}
+
+void gs_effect_set_float(gs_eparam_t *, float) {}
+
+void gs_effect_set_vec2(gs_eparam_t *, const struct vec2 *) {}
+
+void gs_effect_set_vec4(gs_eparam_t *, const struct vec4 *) {}
+
+void gs_effect_set_texture(gs_eparam_t *, gs_texture_t *) {}
+
+void gs_effect_set_val(gs_eparam_t *, const void *, size_t) {}
+
+size_t gs_technique_begin(gs_technique_t *)
+{
+	return 1;
+}
+
+void gs_technique_end(gs_technique_t *) {}
+
+bool gs_technique_begin_pass(gs_technique_t *, size_t)
+{
+	return true;
+}
+
+void gs_technique_end_pass(gs_technique_t *) {}
+
+gs_texrender_t *gs_texrender_create(enum gs_color_format, enum gs_zstencil_format)
+{
+	return reinterpret_cast<gs_texrender_t *>(new_gs_object());
+}
+
+void gs_texrender_destroy(gs_texrender_t *texrender)
+{
+	delete_gs_object(texrender);
+}
+
+bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx, uint32_t cy)
+{
+	return texrender && cx > 0 && cy > 0;
+}
+
+void gs_texrender_end(gs_texrender_t *) {}
+
+void gs_texrender_reset(gs_texrender_t *) {}
+
+gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *)
+{
+	return static_cast<gs_texture_t *>(shared_gs_object());
+}
+
+gs_texture_t *gs_texture_create(uint32_t, uint32_t, enum gs_color_format, uint32_t, const uint8_t **, uint32_t)
+{
+	return reinterpret_cast<gs_texture_t *>(new_gs_object());
+}
+
+void gs_texture_destroy(gs_texture_t *tex)
+{
+	if (tex != shared_gs_object())
+		delete_gs_object(tex);
+}
+
+void gs_texture_set_image(gs_texture_t *, const uint8_t *, uint32_t, bool) {}
+
+void gs_draw_sprite(gs_texture_t *, uint32_t, uint32_t, uint32_t) {}
+
+void gs_clear(uint32_t, const struct vec4 *, float, uint8_t) {}
+
+void gs_ortho(float, float, float, float, float, float) {}
+
+void gs_projection_push(void) {}
+
+void gs_projection_pop(void) {}
+
+void gs_matrix_push(void) {}
+
+void gs_matrix_pop(void) {}
+
+void gs_matrix_translate3f(float, float, float) {}
+
+void gs_matrix_scale3f(float, float, float) {}
+
+void gs_matrix_rotaa4f(float, float, float, float) {}
+
+void gs_blend_state_push(void) {}
+
+void gs_blend_state_pop(void) {}
+
+void gs_reset_blend_state(void) {}
+
+void gs_enable_blending(bool) {}
+
+void gs_blend_function(enum gs_blend_type, enum gs_blend_type) {}
+
+gs_timer_t *gs_timer_create()
+{
+	return reinterpret_cast<gs_timer_t *>(new_gs_object());
+}
+
+void gs_timer_destroy(gs_timer_t *timer)
+{
+	delete_gs_object(timer);
+}
+
+void gs_timer_begin(gs_timer_t *) {}
+
+void gs_timer_end(gs_timer_t *) {}
+
+bool gs_timer_get_data(gs_timer_t *, uint64_t *)
+{
+	return false;
+}
+
+gs_timer_range_t *gs_timer_range_create()
+{
+	return reinterpret_cast<gs_timer_range_t *>(new_gs_object());
+}
+
+void gs_timer_range_destroy(gs_timer_range_t *range)
+{
+	delete_gs_object(range);
+}
+
+void gs_timer_range_begin(gs_timer_range_t *) {}
+
+void gs_timer_range_end(gs_timer_range_t *) {}
+
+bool gs_timer_range_get_data(gs_timer_range_t *, bool *, uint64_t *)
+{
+	return false;
+}
+
+// ---------------------------------------------------------------------------
+// Platform
+// ---------------------------------------------------------------------------
+uint64_t os_gettime_ns(void)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		       std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+void os_sleep_ms(uint32_t duration)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+}
+
+void os_set_thread_name(const char *) {}
+
+int os_get_logical_cores(void)
+{
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+FILE *os_fopen(const char *path, const char *mode)
+{
+	return path && mode ? fopen(path, mode) : nullptr;
+}
+
+char *os_quick_read_utf8_file(const char *path)
+{
+	if (!path)
+		return nullptr;
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return nullptr;
+	std::ostringstream text;
+	text << in.rdbuf();
+	std::string s = text.str();
+	if (s.compare(0, 3, "\xEF\xBB\xBF") == 0)
+		s.erase(0, 3);
+	return dup_string(s);
+}
+
+char *os_get_abs_path_ptr(const char *path)
+{
+	if (!path)
+		return nullptr;
+	std::error_code ec;
+	const std::filesystem::path abs = std::filesystem::absolute(path, ec);
+	return ec ? nullptr : dup_string(abs.string());
+}
+
+const char *os_get_path_extension(const char *path)
+{
+	if (!path)
+		return nullptr;
+	const char *slash = strrchr(path, '/');
+	const char *dot = strrchr(slash ? slash : path, '.');
+	return dot;
+}
+
+int os_mkdirs(const char *path)
+{
+	std::error_code ec;
+	if (!path)
+		return MKDIR_ERROR;
+	if (std::filesystem::is_directory(path, ec))
+		return MKDIR_EXISTS;
+	return std::filesystem::create_directories(path, ec) ? MKDIR_SUCCESS : MKDIR_ERROR;
+}
+
+os_dir_t *os_opendir(const char *path)
+{
+	std::error_code ec;
+	std::filesystem::directory_iterator it(path ? path : "", ec);
+	if (ec)
+		return nullptr;
+	auto *dir = new stub_dir;
+	dir->it = std::move(it);
+	return reinterpret_cast<os_dir_t *>(dir);
+}
+
+struct os_dirent *os_readdir(os_dir_t *dir)
+{
+	auto *d = reinterpret_cast<stub_dir *>(dir);
+	if (!d || d->it == std::filesystem::directory_iterator())
+		return nullptr;
+	const std::filesystem::directory_entry &entry = *d->it;
+	const std::string name = entry.path().filename().string();
+	snprintf(d->entry.d_name, sizeof(d->entry.d_name), "%s", name.c_str());
+	std::error_code ec;
+	d->entry.directory = entry.is_directory(ec);
+	d->it.increment(ec);
+	if (ec)
+		d->it = std::filesystem::directory_iterator();
+	return &d->entry;
+}
+
+void os_closedir(os_dir_t *dir)
+{
+	delete reinterpret_cast<stub_dir *>(dir);
+}
+
+} // extern "C"
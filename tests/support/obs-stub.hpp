@@ -0,0 +1,53 @@
+#pragma once
+
+#include <obs-module.h>
+
+#include <cstdint>
+
+// Control surface of the libobs stand-in the headless targets under tests/
+// link against instead of libobs. The stand-in implements the part of the
+// libobs API the plugin calls, with the real signatures, and keeps just
+// enough state for the plugin to run headless: settings objects, a source
+// list with audio capture callbacks, registered source types and a graphics
+// lock. Every gs_* call succeeds on opaque dummy objects and draws nothing.
+// Signals are never emitted.
+
+// Messages below this level are dropped; LOG_WARNING by default.
+void obs_stub_set_log_level(int level);
+// Number of LOG_ERROR / LOG_WARNING messages logged so far.
+uint32_t obs_stub_error_count();
+uint32_t obs_stub_warning_count();
+
+// Directory obs_module_file() resolves against (normally the repo's data/)
+// and directory obs_module_config_path() resolves against. Both are unset by
+// default, which makes the corresponding calls return null.
+void obs_stub_set_module_data_path(const char *path);
+void obs_stub_set_module_config_path(const char *path);
+
+// What obs_get_video_info() / obs_get_video_frame_time() report.
+void obs_stub_set_video(uint32_t width, uint32_t height, uint32_t fps);
+void obs_stub_set_video_frame_time(uint64_t ns);
+
+// Plain input source that only produces audio, for plugin sources to bind
+// to. The source list keeps one reference until obs_stub_remove_source().
+obs_source_t *obs_stub_add_audio_input(const char *name);
+void obs_stub_remove_source(obs_source_t *source);
+
+// Calls every audio capture callback registered on source, holding the same
+// per-source lock obs_source_remove_audio_capture_callback() takes, as OBS
+// does.
+void obs_stub_emit_audio(obs_source_t *source, const audio_data *audio, bool muted);
+
+// Type info passed to obs_register_source(), or null when id is unknown.
+const obs_source_info *obs_stub_find_source_info(const char *id);
+
+// Creates an instance of a registered source type the way OBS does: the
+// type's defaults are applied to settings, create() is called and the
+// returned data is kept on the source. filter_target is the source a filter
+// is attached to and must be null for inputs. obs_stub_destroy_source()
+// calls destroy() and drops the source.
+obs_source_t *obs_stub_create_source(const char *id, const char *name, obs_data_t *settings,
+				     obs_source_t *filter_target);
+void obs_stub_destroy_source(obs_source_t *source);
+void *obs_stub_source_data(obs_source_t *source);
+void obs_stub_set_showing(obs_source_t *source, bool showing);
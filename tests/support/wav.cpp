@@ -0,0 +1,142 @@
+#include "wav.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static constexpr uint16_t kFormatPcm = 1;
+static constexpr uint16_t kFormatFloat = 3;
+static constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+static uint16_t read_u16(const uint8_t *p)
+{
+	return uint16_t(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static void put_u16(std::vector<uint8_t> &out, uint16_t v)
+{
+	out.push_back(uint8_t(v & 0xFF));
+	out.push_back(uint8_t(v >> 8));
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+		out.push_back(uint8_t((v >> (8 * i)) & 0xFF));
+}
+
+static void put_tag(std::vector<uint8_t> &out, const char *tag)
+{
+	out.insert(out.end(), tag, tag + 4);
+}
+
+bool wav_read(const std::string &path, wav_audio &out, std::string &error)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		error = "cannot open " + path;
+		return false;
+	}
+	const std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (file.size() < 12 || memcmp(file.data(), "RIFF", 4) != 0 || memcmp(file.data() + 8, "WAVE", 4) != 0) {
+		error = path + " is not a RIFF/WAVE file";
+		return false;
+	}
+
+	uint16_t format = 0;
+	uint16_t channels = 0;
+	uint32_t rate = 0;
+	uint16_t bits = 0;
+	const uint8_t *data = nullptr;
+	size_t data_size = 0;
+
+	for (size_t pos = 12; pos + 8 <= file.size();) {
+		const uint8_t *chunk = file.data() + pos;
+		const size_t size = read_u32(chunk + 4);
+		const size_t avail = std::min(size, file.size() - pos - 8);
+		if (memcmp(chunk, "fmt ", 4) == 0 && avail >= 16) {
+			format = read_u16(chunk + 8);
+			channels = read_u16(chunk + 10);
+			rate = read_u32(chunk + 12);
+			bits = read_u16(chunk + 22);
+			if (format == kFormatExtensible && avail >= 26)
+				format = read_u16(chunk + 32);
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			data = chunk + 8;
+			data_size = avail;
+		}
+		// Chunks are padded to an even size.
+		pos += 8 + size + (size & 1);
+	}
+
+	if (!data || channels == 0 || rate == 0) {
+		error = path + " has no fmt or data chunk";
+		return false;
+	}
+	if (!(format == kFormatPcm && bits == 16) && !(format == kFormatFloat && bits == 32)) {
+		error = path + ": only 16-bit PCM and 32-bit float are supported";
+		return false;
+	}
+
+	out.sample_rate = int(rate);
+	out.channels = int(channels);
+	const size_t bytes = bits / 8;
+	const size_t count = data_size / bytes / channels * channels;
+	out.samples.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		const uint8_t *p = data + i * bytes;
+		if (format == kFormatFloat) {
+			const uint32_t raw = read_u32(p);
+			memcpy(&out.samples[i], &raw, sizeof(float));
+		} else {
+			out.samples[i] = float(int16_t(read_u16(p))) / 32768.0f;
+		}
+	}
+	return true;
+}
+
+bool wav_write(const std::string &path, const wav_audio &audio, bool float_format)
+{
+	const uint16_t bits = float_format ? 32 : 16;
+	const uint16_t block = uint16_t(audio.channels * bits / 8);
+	const uint32_t data_size = uint32_t(audio.samples.size() * bits / 8);
+
+	std::vector<uint8_t> out;
+	out.reserve(44 + data_size);
+	put_tag(out, "RIFF");
+	put_u32(out, 36 + data_size);
+	put_tag(out, "WAVE");
+	put_tag(out, "fmt ");
+	put_u32(out, 16);
+	put_u16(out, float_format ? kFormatFloat : kFormatPcm);
+	put_u16(out, uint16_t(audio.channels));
+	put_u32(out, uint32_t(audio.sample_rate));
+	put_u32(out, uint32_t(audio.sample_rate) * block);
+	put_u16(out, block);
+	put_u16(out, bits);
+	put_tag(out, "data");
+	put_u32(out, data_size);
+
+	for (float v : audio.samples) {
+		if (float_format) {
+			uint32_t raw;
+			memcpy(&raw, &v, sizeof(raw));
+			put_u32(out, raw);
+		} else {
+			const float clipped = std::clamp(v, -1.0f, 1.0f);
+			put_u16(out, uint16_t(int16_t(std::lround(clipped * 32767.0f))));
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char *>(out.data()), std::streamsize(out.size()));
+	return bool(file);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Minimal RIFF/WAVE reader and writer for the test fixtures: 16-bit PCM and
+// 32-bit float, any channel count. Samples are kept interleaved as float,
+// with 16-bit PCM scaled to -1..1.
+struct wav_audio {
+	int sample_rate = 48000;
+	int channels = 1;
+	std::vector<float> samples;
+
+	size_t frames() const { return channels > 0 ? samples.size() / (size_t)channels : 0; }
+};
+
+// Returns false and fills error when the file is missing or not a WAV this
+// reader understands.
+bool wav_read(const std::string &path, wav_audio &out, std::string &error);
+
+// float_format writes 32-bit float samples unchanged, otherwise 16-bit PCM
+// with samples clipped to -1..1.
+bool wav_write(const std::string &path, const wav_audio &audio, bool float_format);